@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 1995-2021, Nikolay Pultsin <geometer@geometer.name>
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <algorithm>
+#include <cmath>
+
+#include "ConvergenceMonitor.h"
+
+namespace KE::ThreeD {
+
+const char *ConvergenceMonitor::description(Reason reason) {
+	switch (reason) {
+		case Reason::energy:
+			return "the energy does not decrease";
+		case Reason::gradient:
+			return "the gradient is small";
+		case Reason::displacement:
+			return "the points do not move";
+		case Reason::stalled:
+			return "no step decreases the energy";
+		default:
+			return "not converged";
+	}
+}
+
+ConvergenceMonitor::ConvergenceMonitor(const Tolerances &tolerances) {
+	this->setTolerances(tolerances);
+}
+
+void ConvergenceMonitor::setTolerances(const Tolerances &tolerances) {
+	this->_tolerances = tolerances;
+	this->_tolerances.window = std::max(tolerances.window, (std::size_t)2);
+	this->energies.resize(this->_tolerances.window);
+	this->gradientNorms.resize(this->_tolerances.window);
+	this->stepSizes.resize(this->_tolerances.window);
+	this->reset();
+}
+
+void ConvergenceMonitor::reset() {
+	this->_numberOfIterations = 0;
+	this->initialGradientNorm = NAN;
+}
+
+// Энергию и норму градиента сообщают не все оптимизаторы; неизвестные
+// значения хранятся как NaN, и критерий, которому они нужны, не проверяется.
+ConvergenceMonitor::Reason ConvergenceMonitor::add(const StepReport &report) {
+	const std::size_t window = this->_tolerances.window;
+	const std::size_t index = this->_numberOfIterations % window;
+	this->energies[index] = report.hasEnergy ? report.energy : NAN;
+	this->gradientNorms[index] = report.hasGradientNorm ? report.gradientNorm : NAN;
+	this->stepSizes[index] = report.stepSize;
+	this->_numberOfIterations += 1;
+	if (this->_numberOfIterations <= window && report.hasGradientNorm) {
+		this->initialGradientNorm = std::isnan(this->initialGradientNorm) ?
+			report.gradientNorm : std::max(this->initialGradientNorm, report.gradientNorm);
+	}
+	if (this->_numberOfIterations < window) {
+		return Reason::none;
+	}
+
+	// Самый старый отчёт в окне лежит сразу после самого нового.
+	const std::size_t oldest = this->_numberOfIterations % window;
+	const double maxStep = *std::max_element(this->stepSizes.begin(), this->stepSizes.end());
+	if (maxStep == 0.0) {
+		return Reason::stalled;
+	}
+
+	const double firstEnergy = this->energies[oldest];
+	const double lastEnergy = this->energies[index];
+	if (this->_tolerances.energy > 0.0 && !std::isnan(firstEnergy) && !std::isnan(lastEnergy)) {
+		// Нормированная энергия окружности равна нулю, поэтому убывание
+		// меряем не относительно самой энергии, а относительно max(|E|, 1).
+		const double decrease = (firstEnergy - lastEnergy) / std::max(fabs(firstEnergy), 1.0);
+		// Энергия могла вырасти, только если узел изменили извне.
+		if (decrease >= 0.0 && decrease < this->_tolerances.energy) {
+			return Reason::energy;
+		}
+	}
+
+	// Разброс нормы градиента по окну ничего не говорит о близости
+	// к минимуму (она может долго колебаться около постоянного значения,
+	// пока энергия убывает); сравниваем её с нормой в начале сглаживания.
+	const bool allGradientNormsKnown = std::none_of(this->gradientNorms.begin(), this->gradientNorms.end(), [](double norm) {
+		return std::isnan(norm);
+	});
+	if (this->_tolerances.gradient > 0.0 && this->initialGradientNorm > 0.0 && allGradientNormsKnown) {
+		const double max = *std::max_element(this->gradientNorms.begin(), this->gradientNorms.end());
+		if (max < this->_tolerances.gradient * this->initialGradientNorm) {
+			return Reason::gradient;
+		}
+	}
+
+	if (this->_tolerances.displacement > 0.0 && maxStep < this->_tolerances.displacement) {
+		return Reason::displacement;
+	}
+
+	return Reason::none;
+}
+
+}
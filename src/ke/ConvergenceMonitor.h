@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 1995-2021, Nikolay Pultsin <geometer@geometer.name>
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __KE_CONVERGENCE_MONITOR_H__
+#define __KE_CONVERGENCE_MONITOR_H__
+
+#include <vector>
+
+#include "Optimizer.h"
+
+namespace KE::ThreeD {
+
+// Watches the step reports over a sliding window of iterations
+// and decides when the smoothing makes no more sense.
+class ConvergenceMonitor {
+
+public:
+	enum class Reason {
+		// not converged yet
+		none,
+		// the energy decreased over the window by less than the tolerance
+		// times max(|energy|, 1); the normalized energy of a round circle is 0
+		energy,
+		// the gradient norm stayed below the tolerance times its maximum
+		// over the first window
+		gradient,
+		// no vertex moved by more than the tolerance (in average edge lengths) in the window
+		displacement,
+		// no step was accepted in the window
+		stalled
+	};
+
+	struct Tolerances {
+		std::size_t window;
+		double energy;
+		double gradient;
+		double displacement;
+	};
+
+	static const char *description(Reason reason);
+
+private:
+	Tolerances _tolerances;
+	// ring buffers of the last window reports; NaN for an unknown value
+	std::vector<double> energies, gradientNorms, stepSizes;
+	std::size_t _numberOfIterations;
+	// maximal gradient norm over the first window, NaN if unknown
+	double initialGradientNorm;
+
+public:
+	// A tolerance <= 0 disables the corresponding criterion.
+	ConvergenceMonitor(const Tolerances &tolerances = {50, 1e-7, 1e-3, 1e-4});
+
+	const Tolerances &tolerances() const { return this->_tolerances; }
+	void setTolerances(const Tolerances &tolerances);
+
+	// Forgets the reports; called when the knot is changed not by the smoothing.
+	void reset();
+	// Adds the report of the next iteration; returns the reason
+	// why the smoothing can be stopped, or Reason::none.
+	Reason add(const StepReport &report);
+	std::size_t numberOfIterations() const { return this->_numberOfIterations; }
+};
+
+}
+
+#endif /* __KE_CONVERGENCE_MONITOR_H__ */
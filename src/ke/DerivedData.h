@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 1995-2021, Nikolay Pultsin <geometer@geometer.name>
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __KE_DERIVED_DATA_H__
+#define __KE_DERIVED_DATA_H__
+
+#include <atomic>
+
+#include "Knot.h"
+
+namespace KE::ThreeD {
+
+// A node of the graph of data derived from the knot points. The value is
+// computed from a snapshot by the function; the function may read other
+// nodes (or Snapshot::cached<>() data) for the same snapshot, so the shared
+// intermediates are computed once. Values are kept in the snapshot cache:
+// a value is computed lazily, at most once per knot generation, and is
+// released together with the snapshot. invalidate() is for the parameters
+// of the function other than the points (e.g., the tube thickness).
+template<typename T>
+class DerivedData {
+
+public:
+	typedef std::function<std::shared_ptr<const T>(const Knot::Snapshot&)> Function;
+
+private:
+	const std::size_t key;
+	const Function function;
+	std::atomic<std::size_t> version;
+
+public:
+	DerivedData(const Function &function) : key(Knot::Snapshot::newKey()), function(function), version(0) {}
+
+	std::shared_ptr<const T> value(const Knot::Snapshot &snapshot) const {
+		return std::static_pointer_cast<const T>(snapshot.cachedValue(this->key, this->version, [this, &snapshot] {
+			return std::static_pointer_cast<const void>(this->function(snapshot));
+		}));
+	}
+	// The value for the snapshot if it is already computed, nullptr otherwise.
+	std::shared_ptr<const T> storedValue(const Knot::Snapshot &snapshot) const {
+		return std::static_pointer_cast<const T>(snapshot.storedValue(this->key, this->version));
+	}
+
+	// Makes the values computed before obsolete.
+	void invalidate() { this->version += 1; }
+
+private:
+	DerivedData(const DerivedData&) = delete;
+	DerivedData& operator = (const DerivedData&) = delete;
+};
+
+}
+
+#endif /* __KE_DERIVED_DATA_H__ */
@@ -21,17 +21,21 @@
 
 namespace KE::TwoD {
 
-Diagram::Diagram() : caption("New Diagram"), _isClosed(false) {
+Diagram::Diagram() : caption("New Diagram"), _isClosed(false), _generation(1), sequenceGeneration(0) {
 }
 
 void Diagram::clear() {
 	this->_vertices.clear();
+	this->slots.clear();
+	this->crossingTable.clear();
+	this->overTable.clear();
 	this->_isClosed = false;
+	this->updateEdges();
 }
 
 void Diagram::order() {
-	for (Edge &edge : this->edges()) {
-		edge.orderCrossings(edge.start->crossings);
+	for (const Edge &edge : this->_edges) {
+		edge.orderCrossings(this->crossingTable[edge.start->id]);
 	}
 }
 
@@ -39,23 +43,38 @@ void Diagram::shift(int dx, int dy) {
 	for (auto vertex : this->vertices()) {
 		vertex->move(dx, dy);
 	}
+	this->updateCrossings(nullptr);
 }
 
-std::list<Diagram::Edge> Diagram::edges() const {
-	std::list<Edge> edges;
-
-	std::shared_ptr<Vertex> previous = nullptr;
-	for (auto vertex : this->vertices()) {
-		if (previous) {
-			edges.push_back(Edge(previous, vertex));
+void Diagram::updateEdges() {
+	this->_generation += 1;
+	this->_edges.clear();
+	for (std::size_t index = 0; index < this->_vertices.size(); ++index) {
+		this->_vertices[index]->position = index;
+		if (index > 0) {
+			this->_edges.push_back(Edge(this->_vertices[index - 1], this->_vertices[index]));
 		}
-		previous = vertex;
 	}
-	if (this->_isClosed && this->vertices().size() >= 2) {
-		edges.push_back(Edge(this->vertices().back(), this->vertices().front()));
+	if (this->_isClosed && this->_vertices.size() >= 2) {
+		this->_edges.push_back(Edge(this->_vertices.back(), this->_vertices.front()));
+	}
+}
+
+const Diagram::Edge *Diagram::edgeTo(const Vertex &vertex) const {
+	if (!this->contains(vertex)) {
+		return nullptr;
+	}
+	if (vertex.position > 0) {
+		return &this->_edges[vertex.position - 1];
 	}
+	return this->_isClosed && this->_edges.size() >= 2 ? &this->_edges.back() : nullptr;
+}
 
-	return edges;
+const Diagram::Edge *Diagram::edgeFrom(const Vertex &vertex) const {
+	if (!this->contains(vertex) || vertex.position >= this->_edges.size()) {
+		return nullptr;
+	}
+	return &this->_edges[vertex.position];
 }
 
 std::shared_ptr<Diagram::Vertex> Diagram::findVertex(const FloatPoint &pt, float maxDistance) const {
@@ -79,11 +98,10 @@ std::shared_ptr<Diagram::Crossing> Diagram::findCrossing(const FloatPoint &pt, f
 
 	for (const auto &edge : this->edges()) {
 		for (const auto &crs : this->underCrossings(edge)) {
-			const auto coords = crs.coords();
-			if (!coords) {
+			if (crs.parallel) {
 				continue;
 			}
-			const float distance = pt.distance(*coords);
+			const float distance = pt.distance(FloatPoint(crs._x, crs._y));
 			if (distance < best && distance <= maxDistance) {
 				best = distance;
 				found = std::make_shared<Crossing>(crs);
@@ -161,21 +179,47 @@ bool Diagram::Edge::intersects(const Diagram::Edge &edge) const {
 		ori == orientation(edge.end, this->start, edge.start);
 }
 
-std::map<Diagram::Edge,std::list<Diagram::Crossing>> Diagram::allCrossings() const {
-	const auto edges = this->edges();
-	std::map<Diagram::Edge,std::list<Diagram::Crossing>> map;
+const Diagram::CrossingSequence &Diagram::crossingSequence() const {
+	if (this->sequenceGeneration == this->_generation) {
+		return this->sequence;
+	}
+
+	const auto &edges = this->_edges;
+	auto &offsets = this->sequence.offsets;
+	offsets.assign(edges.size() + 1, 0);
 	for (const auto &edge : edges) {
-		const auto crossings = this->underCrossings(edge);
-		auto &list = map[edge];
-		list.insert(list.end(), crossings.begin(), crossings.end());
-		for (const auto &crs : crossings) {
-			map[crs.up].push_back(crs);
+		for (const auto &crs : this->underCrossings(edge)) {
+			offsets[edge.start->position + 1] += 1;
+			offsets[crs.up.start->position + 1] += 1;
 		}
 	}
+	for (std::size_t index = 0; index < edges.size(); ++index) {
+		offsets[index + 1] += offsets[index];
+	}
+
+	// Раскладываем пересечения по рёбрам, на которых они лежат: сначала
+	// нижнее ребро, потом верхнее, в порядке обхода нижних рёбер.
+	std::vector<const Crossing*> entries(offsets.back());
+	std::vector<std::size_t> next(offsets.begin(), offsets.end() - 1);
 	for (const auto &edge : edges) {
-		edge.orderCrossings(map[edge]);
+		for (const auto &crs : this->underCrossings(edge)) {
+			entries[next[edge.start->position]++] = &crs;
+			entries[next[crs.up.start->position]++] = &crs;
+		}
 	}
-	return map;
+
+	auto &crossings = this->sequence.crossings;
+	crossings.clear();
+	crossings.reserve(entries.size());
+	for (const Crossing *crs : entries) {
+		crossings.push_back(*crs);
+	}
+	for (std::size_t index = 0; index < edges.size(); ++index) {
+		edges[index].orderCrossings(crossings.begin() + offsets[index], crossings.begin() + offsets[index + 1]);
+	}
+
+	this->sequenceGeneration = this->_generation;
+	return this->sequence;
 }
 
 }
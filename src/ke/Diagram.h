@@ -20,10 +20,9 @@
 #include <cmath>
 #include <functional>
 #include <limits>
-#include <list>
-#include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <rapidjson/document.h>
 
@@ -49,14 +48,21 @@ public:
 	friend class Diagram;
 
 	private:
-		std::list<Crossing> crossings;
+		static constexpr std::size_t NO_ID = std::numeric_limits<std::size_t>::max();
+
+	private:
 		int _x, _y;
+		// Slot in the vertex table of the diagram; stable while the vertex
+		// is in the diagram. NO_ID for the vertices created outside.
+		std::size_t id;
+		// Index in the vertex list; edge number position starts at the vertex.
+		std::size_t position;
 
 	public:
 		const std::size_t index;
 
 	public:
-		Vertex(int x, int y, std::size_t index) : _x(x), _y(y), index(index) {}
+		Vertex(int x, int y, std::size_t index) : _x(x), _y(y), id(NO_ID), position(0), index(index) {}
 
 		void move(int dx, int dy) { this->_x += dx; this->_y += dy; }
 		void moveTo(int x, int y) { this->_x = x; this->_y = y; }
@@ -72,8 +78,8 @@ public:
 
 	friend class Diagram;
 
-		const std::shared_ptr<Vertex> start;
-		const std::shared_ptr<Vertex> end;
+		std::shared_ptr<Vertex> start;
+		std::shared_ptr<Vertex> end;
 
 		Edge(const std::shared_ptr<Vertex> &start, const std::shared_ptr<Vertex> &end) : start(start), end(end) {
 		}
@@ -86,27 +92,73 @@ public:
 		bool operator < (const Edge &edge) const { return this->start < edge.start || (this->start == edge.start && this->end < edge.end); }
 
 	private:
-		void orderCrossings(std::list<Crossing> &crossings) const;
+		void orderCrossings(std::vector<Crossing> &crossings) const {
+			this->orderCrossings(crossings.begin(), crossings.end());
+		}
+		void orderCrossings(std::vector<Crossing>::iterator begin, std::vector<Crossing>::iterator end) const;
 	};
 
 	struct Crossing {
-		const Edge up, down;
 
-		Crossing(const Edge &up, const Edge &down) : up(up), down(down) {}
+	friend class Diagram;
+
+		Edge up, down;
+
+	private:
+		// The intersection point and its parametric positions along the edges
+		// (0 at the start, 1 at the end), cached at construction; the diagram
+		// updates them when an incident edge moves.
+		bool parallel;
+		float _x, _y;
+		float upPosition, downPosition;
 
+	public:
+		Crossing(const Edge &up, const Edge &down) : up(up), down(down) { this->update(); }
+
+		// nullptr for parallel edges
 		std::shared_ptr<FloatPoint> coords() const;
+		// Parametric position of the crossing along the edge (up or down).
+		float position(const Edge &edge) const { return edge == this->up ? this->upPosition : this->downPosition; }
 
 		bool operator == (const Crossing &crs) const { return this->up == crs.up && this->down == crs.down; }
 		// for using in maps
 		bool operator < (const Crossing &crs) const { return this->up < crs.up || (this->up == crs.up && this->down < crs.down); }
+
+	private:
+		void update();
+	};
+
+	// The crossings along the diagram, edge by edge in the order of edges(),
+	// and along every edge in the order of the crossing positions.
+	// Every crossing is met twice: on the up and on the down edge.
+	struct CrossingSequence {
+		std::vector<Crossing> crossings;
+		// the crossings on the edge number i are [offsets[i], offsets[i + 1])
+		std::vector<std::size_t> offsets;
 	};
 
 	public:
 		std::string caption;
 
 	private:
-		std::list<std::shared_ptr<Vertex>> _vertices;
+		// Vertices in the order along the diagram.
+		std::vector<std::shared_ptr<Vertex>> _vertices;
+		// Edge i starts at vertex i; rebuilt when the vertex list is changed
+		// (not when a vertex is moved).
+		std::vector<Edge> _edges;
+		// Indexed by vertex id: the vertex (nullptr for a removed one) and
+		// the crossings under the edge that starts at it, ordered along the edge.
+		std::vector<Vertex*> slots;
+		std::vector<std::vector<Crossing>> crossingTable;
+		// Indexed by vertex id: the ids of the vertices under the edges of
+		// which the edge that starts at it has (or had) crossings. May keep
+		// ids of removed crossings; they are dropped by updateCrossings().
+		std::vector<std::vector<std::size_t>> overTable;
 		bool _isClosed;
+		// Incremented on every change of vertices, edges or crossings.
+		std::size_t _generation;
+		mutable CrossingSequence sequence;
+		mutable std::size_t sequenceGeneration;
 
 	public:
 		Diagram();
@@ -118,11 +170,14 @@ public:
 		void close();
 		bool isClosed() const { return this->_isClosed; }
 
-		const std::list<std::shared_ptr<Vertex>> &vertices() const { return this->_vertices; }
-		std::list<Edge> edges() const;
-		const std::list<Crossing> &underCrossings(const Edge &edge) const { return edge.start->crossings; }
-		std::map<Diagram::Edge,std::list<Diagram::Crossing>> allCrossings() const;
+		const std::vector<std::shared_ptr<Vertex>> &vertices() const { return this->_vertices; }
+		const std::vector<Edge> &edges() const { return this->_edges; }
+		// Empty for an edge that does not start at a vertex of the diagram.
+		const std::vector<Crossing> &underCrossings(const Edge &edge) const;
+		// Rebuilt at most once per generation.
+		const CrossingSequence &crossingSequence() const;
 		bool hasCrossings() const;
+		std::size_t generation() const { return this->_generation; }
 
 		std::shared_ptr<Vertex> addVertex(int x, int y);
 		std::shared_ptr<Vertex> addVertex(const Edge &edge, int x, int y);
@@ -143,6 +198,27 @@ public:
 		std::shared_ptr<Crossing> findCrossing(const FloatPoint &pt, float maxDistance) const;
 
 	private:
+		bool contains(const Vertex &vertex) const {
+			return vertex.id < this->slots.size() && this->slots[vertex.id] == &vertex;
+		}
+		std::vector<Crossing> *crossingsUnder(const Edge &edge);
+		// Edges ending and starting at the vertex, nullptr if there is no such edge.
+		const Edge *edgeTo(const Vertex &vertex) const;
+		const Edge *edgeFrom(const Vertex &vertex) const;
+		std::size_t newIndex() const;
+		std::shared_ptr<Vertex> newVertex(int x, int y, std::size_t index);
+		void releaseVertex(const Vertex &vertex);
+		void updateEdges();
+		// Updates the cached points of the crossings on the edges incident
+		// to the vertex, or of all the crossings if vertex is nullptr.
+		void updateCrossings(const Vertex *vertex);
+		// Adds the crossing to overTable.
+		void indexCrossing(const Edge &up, const Edge &down);
+		// For a diagram without crossings: adds a crossing for every pair
+		// of intersecting edges, the later edge over the earlier one,
+		// the same as adding the vertices one by one does.
+		void addAllCrossings();
+
 		std::shared_ptr<Vertex> addVertex(int x, int y, std::size_t index);
 		std::shared_ptr<Crossing> addCrossing(const Edge &up, const Edge &down);
 		// returns true if the crossing has been removed
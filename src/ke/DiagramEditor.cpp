@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+
 #include "DiagramEditor.h"
 
 namespace KE::TwoD {
@@ -41,26 +43,16 @@ std::shared_ptr<Diagram::Vertex> DiagramEditor::addVertex(int x, int y) {
 namespace {
 
 template<typename T>
-std::size_t indexOf(const T &element, const std::list<T> &collection) {
-	std::size_t index = 0;
-	for (const auto &elt : collection) {
-		if (elt == element) {
-			break;
-		}
-		index += 1;
-	}
-	return index;
+std::size_t indexOf(const T &element, const std::vector<T> &collection) {
+	return std::find(collection.begin(), collection.end(), element) - collection.begin();
 }
 
 template<typename T>
-const T& elementAt(std::size_t index, const std::list<T> &collection) {
-	for (const auto &elt : collection) {
-		if (index == 0) {
-			return elt;
-		}
-		index -= 1;
+const T& elementAt(std::size_t index, const std::vector<T> &collection) {
+	if (index >= collection.size()) {
+		throw std::runtime_error("Index out of range");
 	}
-	throw std::runtime_error("Index out of range");
+	return collection[index];
 }
 
 struct AddVertexOnEdgeCommand : public DiagramEditor::Command {
@@ -128,7 +120,7 @@ bool DiagramEditor::canRemoveEdge(const std::shared_ptr<Diagram::Edge> &edge) co
 	if (this->currentDiagram->isClosed()) {
 		return true;
 	}
-	const auto edges = this->currentDiagram->edges();
+	const auto &edges = this->currentDiagram->edges();
 	return *edge == edges.front() || *edge == edges.back();
 }
 
@@ -173,7 +165,7 @@ struct FlipCrossingCommand : public DiagramEditor::Command {
 	FlipCrossingCommand(std::size_t indexUp, std::size_t indexDown) : indexUp(indexUp), indexDown(indexDown) {}
 
 	void play(Diagram &diagram) override {
-		const auto edges = diagram.edges();
+		const auto &edges = diagram.edges();
 		auto crossing = diagram.getCrossing(
 			elementAt(this->indexUp, edges), elementAt(this->indexDown, edges)
 		);
@@ -184,7 +176,7 @@ struct FlipCrossingCommand : public DiagramEditor::Command {
 }
 
 std::shared_ptr<Diagram::Crossing> DiagramEditor::flipCrossing(Diagram::Crossing &crossing) {
-	const auto edges = this->currentDiagram->edges();
+	const auto &edges = this->currentDiagram->edges();
 	this->addCommand(
 		std::make_shared<FlipCrossingCommand>(
 			indexOf(crossing.up, edges), indexOf(crossing.down, edges)
@@ -62,10 +62,10 @@ public:
 	const std::string &caption() const { return this->currentDiagram->caption; }
 	void setCaption(const std::string &caption);
 
-	const std::list<std::shared_ptr<Diagram::Vertex>> &vertices() const { return this->currentDiagram->vertices(); }
-	std::list<Diagram::Edge> edges() const { return this->currentDiagram->edges(); }
-	const std::list<Diagram::Crossing> &underCrossings(const Diagram::Edge &edge) const { return this->currentDiagram->underCrossings(edge); }
-	std::map<Diagram::Edge,std::list<Diagram::Crossing>> allCrossings() const { return this->currentDiagram->allCrossings(); }
+	const std::vector<std::shared_ptr<Diagram::Vertex>> &vertices() const { return this->currentDiagram->vertices(); }
+	const std::vector<Diagram::Edge> &edges() const { return this->currentDiagram->edges(); }
+	const std::vector<Diagram::Crossing> &underCrossings(const Diagram::Edge &edge) const { return this->currentDiagram->underCrossings(edge); }
+	const Diagram::CrossingSequence &crossingSequence() const { return this->currentDiagram->crossingSequence(); }
 	bool isClosed() const { return this->currentDiagram->isClosed(); }
 
 	std::shared_ptr<Diagram::Vertex> findVertex(const FloatPoint &pt, float maxDistance) const {
@@ -14,17 +14,21 @@
  * limitations under the License.
  */
 
-#include <functional>
+#include <algorithm>
 
 #include "Diagram.h"
 
 namespace KE::TwoD {
 
-std::shared_ptr<FloatPoint> Diagram::Crossing::coords() const {
+void Diagram::Crossing::update() {
 	const float d0 = this->up.dy() * this->down.dx() - this->up.dx() * this->down.dy();
 
-	if (d0 == 0) {
-		return nullptr;
+	this->parallel = d0 == 0;
+	if (this->parallel) {
+		// порядок таких пересечений на ребре не определён
+		this->_x = this->_y = 0;
+		this->upPosition = this->downPosition = 0;
+		return;
 	}
 
 	const auto downStart = this->down.start->coords();
@@ -32,16 +36,76 @@ std::shared_ptr<FloatPoint> Diagram::Crossing::coords() const {
 	const float d1 =
 			(downStart.y - upStart.y) * this->down.dx()
 		-	(downStart.x - upStart.x) * this->down.dy();
+	const float d2 =
+			(upStart.x - downStart.x) * this->up.dy()
+		-	(upStart.y - downStart.y) * this->up.dx();
+
+	this->_x = upStart.x + this->up.dx() * d1 / d0;
+	this->_y = upStart.y + this->up.dy() * d1 / d0;
+	this->upPosition = d1 / d0;
+	this->downPosition = d2 / d0;
+}
+
+std::shared_ptr<FloatPoint> Diagram::Crossing::coords() const {
+	if (this->parallel) {
+		return nullptr;
+	}
+	return std::make_shared<FloatPoint>(this->_x, this->_y);
+}
+
+void Diagram::updateCrossings(const Vertex *vertex) {
+	this->_generation += 1;
+	if (!vertex) {
+		for (auto &crossings : this->crossingTable) {
+			for (auto &crs : crossings) {
+				crs.update();
+			}
+		}
+		return;
+	}
+
+	// Пересечения под ребром лежат в его списке; пересечения над ребром
+	// ищем в списках из overTable, попутно выбрасывая устаревшие номера.
+	for (const Edge *edge : {this->edgeTo(*vertex), this->edgeFrom(*vertex)}) {
+		if (!edge) {
+			continue;
+		}
+		for (auto &crs : this->crossingTable[edge->start->id]) {
+			crs.update();
+		}
+		auto &downs = this->overTable[edge->start->id];
+		downs.erase(std::remove_if(downs.begin(), downs.end(), [this, edge](std::size_t down) {
+			bool found = false;
+			for (auto &crs : this->crossingTable[down]) {
+				if (crs.up == *edge) {
+					crs.update();
+					found = true;
+				}
+			}
+			return !found;
+		}), downs.end());
+	}
+}
+
+void Diagram::indexCrossing(const Edge &up, const Edge &down) {
+	auto &downs = this->overTable[up.start->id];
+	if (std::find(downs.begin(), downs.end(), down.start->id) == downs.end()) {
+		downs.push_back(down.start->id);
+	}
+}
 
-	return std::make_shared<FloatPoint>(
-		upStart.x + this->up.dx() * d1 / d0,
-		upStart.y + this->up.dy() * d1 / d0
-	);
+const std::vector<Diagram::Crossing> &Diagram::underCrossings(const Edge &edge) const {
+	static const std::vector<Crossing> empty;
+	return this->contains(*edge.start) ? this->crossingTable[edge.start->id] : empty;
+}
+
+std::vector<Diagram::Crossing> *Diagram::crossingsUnder(const Edge &edge) {
+	return this->contains(*edge.start) ? &this->crossingTable[edge.start->id] : nullptr;
 }
 
 bool Diagram::hasCrossings() const {
-	for (const auto &vertex : this->vertices()) {
-		if (!vertex->crossings.empty()) {
+	for (const auto &crossings : this->crossingTable) {
+		if (!crossings.empty()) {
 			return true;
 		}
 	}
@@ -49,16 +113,74 @@ bool Diagram::hasCrossings() const {
 	return false;
 }
 
+void Diagram::addAllCrossings() {
+	const auto &edges = this->_edges;
+	struct Extent {
+		int minX, maxX, minY, maxY;
+	};
+	std::vector<Extent> extents;
+	extents.reserve(edges.size());
+	for (const auto &edge : edges) {
+		extents.push_back({
+			std::min(edge.start->_x, edge.end->_x), std::max(edge.start->_x, edge.end->_x),
+			std::min(edge.start->_y, edge.end->_y), std::max(edge.start->_y, edge.end->_y)
+		});
+	}
+
+	// Заметаем вертикальной прямой слева направо; пересекаться могут только
+	// рёбра, проекции которых на обе оси перекрываются. Сами пары проверяем
+	// тем же Edge::intersects, что и при добавлении вершин по одной.
+	std::vector<std::size_t> order(edges.size());
+	for (std::size_t index = 0; index < order.size(); ++index) {
+		order[index] = index;
+	}
+	std::sort(order.begin(), order.end(), [&extents](std::size_t i0, std::size_t i1) {
+		return extents[i0].minX < extents[i1].minX || (extents[i0].minX == extents[i1].minX && i0 < i1);
+	});
+
+	std::vector<std::pair<std::size_t,std::size_t>> pairs;
+	std::vector<std::size_t> active;
+	for (const std::size_t index : order) {
+		const auto &extent = extents[index];
+		active.erase(std::remove_if(active.begin(), active.end(), [&](std::size_t other) {
+			return extents[other].maxX < extent.minX;
+		}), active.end());
+		for (const std::size_t other : active) {
+			if (extents[other].maxY < extent.minY || extent.maxY < extents[other].minY) {
+				continue;
+			}
+			if (edges[other].intersects(edges[index])) {
+				pairs.push_back(std::minmax(other, index));
+			}
+		}
+		active.push_back(index);
+	}
+
+	// в том же порядке, в каком их добавило бы addVertex()
+	std::sort(pairs.begin(), pairs.end(), [](const auto &p0, const auto &p1) {
+		return p0.second < p1.second || (p0.second == p1.second && p0.first < p1.first);
+	});
+	for (const auto &[down, up] : pairs) {
+		this->crossingTable[edges[down].start->id].push_back(Crossing(edges[up], edges[down]));
+		this->indexCrossing(edges[up], edges[down]);
+	}
+	this->_generation += 1;
+	this->order();
+}
+
 std::shared_ptr<Diagram::Crossing> Diagram::addCrossing(const Edge &up, const Edge &down) {
 	this->removeCrossing(up, down);
 
-	if (!up.intersects(down)) {
+	auto crossings = this->crossingsUnder(down);
+	if (!crossings || !up.intersects(down)) {
 		return nullptr;
 	}
 
 	std::shared_ptr<Crossing> new_crossing = std::make_shared<Crossing>(up, down);
-	down.start->crossings.push_back(*new_crossing);
-	down.orderCrossings(down.start->crossings);
+	crossings->push_back(*new_crossing);
+	this->indexCrossing(up, down);
+	this->_generation += 1;
+	down.orderCrossings(*crossings);
 	return new_crossing;
 }
 
@@ -67,21 +189,22 @@ std::shared_ptr<Diagram::Crossing> Diagram::flipCrossing(Crossing &crs) {
 }
 
 bool Diagram::removeCrossing(const Edge &edge1, const Edge &edge2) {
-	auto &list1 = edge1.start->crossings;
-	const auto iter1 = std::find(list1.begin(), list1.end(), Crossing(edge2, edge1));
-	if (iter1 != list1.end()) {
-		list1.erase(iter1);
-		return true;
-	}
-
-	auto &list2 = edge2.start->crossings;
-	const auto iter2 = std::find(list2.begin(), list2.end(), Crossing(edge1, edge2));
-	if (iter2 != list2.end()) {
-		list2.erase(iter2);
+	const auto remove = [this](std::vector<Crossing> *crossings, const Edge &up, const Edge &down) {
+		if (!crossings) {
+			return false;
+		}
+		const auto iter = std::find_if(crossings->begin(), crossings->end(), [&](const Crossing &crs) {
+			return crs.up == up && crs.down == down;
+		});
+		if (iter == crossings->end()) {
+			return false;
+		}
+		crossings->erase(iter);
+		this->_generation += 1;
 		return true;
-	}
+	};
 
-	return false;
+	return remove(this->crossingsUnder(edge1), edge2, edge1) || remove(this->crossingsUnder(edge2), edge1, edge2);
 }
 
 std::shared_ptr<Diagram::Crossing> Diagram::getCrossing(const Edge &edge1, const Edge &edge2) {
@@ -99,22 +222,25 @@ std::shared_ptr<Diagram::Crossing> Diagram::getCrossing(const Edge &edge1, const
 	return nullptr;
 }
 
-void Diagram::Edge::orderCrossings(std::list<Crossing> &crossings) const {
-	std::function<bool(const Crossing&,const Crossing&)> comparator;
-	if (abs(this->dx()) > abs(this->dy())) {
-		if (this->dx() > 0) {
-			comparator = [](const Crossing &c0, const Crossing &c1) { return c0.coords()->x < c1.coords()->x; };
-		} else {
-			comparator = [](const Crossing &c0, const Crossing &c1) { return c0.coords()->x > c1.coords()->x; };
-		}
-	} else {
-		if (this->dy() > 0) {
-			comparator = [](const Crossing &c0, const Crossing &c1) { return c0.coords()->y < c1.coords()->y; };
-		} else {
-			comparator = [](const Crossing &c0, const Crossing &c1) { return c0.coords()->y > c1.coords()->y; };
+void Diagram::Edge::orderCrossings(std::vector<Crossing>::iterator begin, std::vector<Crossing>::iterator end) const {
+	const auto comparator = [this](const Crossing &c0, const Crossing &c1) {
+		return c0.position(*this) < c1.position(*this);
+	};
+	// Списки почти всегда уже упорядочены или почти упорядочены (вершину
+	// сдвинули немного), поэтому сортируем вставками: это устойчиво, как
+	// stable_sort, но на месте, без временного буфера.
+	for (auto current = begin; current != end; ++current) {
+		if (current == begin || !comparator(*current, *(current - 1))) {
+			continue;
 		}
+		Crossing crossing = std::move(*current);
+		auto position = current;
+		do {
+			*position = std::move(*(position - 1));
+			--position;
+		} while (position != begin && comparator(crossing, *(position - 1)));
+		*position = std::move(crossing);
 	}
-	crossings.sort(comparator);
 }
 
 }
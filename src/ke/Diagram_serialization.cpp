@@ -14,7 +14,6 @@
  * limitations under the License.
  */
 
-#include <map>
 #include <vector>
 
 #include "Util_rapidjson.h"
@@ -22,7 +21,7 @@
 
 namespace KE::TwoD {
 
-Diagram::Diagram(const rapidjson::Document &doc) : _isClosed(false) {
+Diagram::Diagram(const rapidjson::Document &doc) : _isClosed(false), _generation(1), sequenceGeneration(0) {
 	if (doc.IsNull()) {
 		throw std::runtime_error("The file is not in JSON format");
 	}
@@ -53,17 +52,17 @@ Diagram::Diagram(const rapidjson::Document &doc) : _isClosed(false) {
 		if (!point.IsArray() || point.Size() != 3 || !point[0].IsInt() || !point[1].IsInt()) {
 			throw std::runtime_error("Each vertex must be an array of three integers");
 		}
-		this->addVertex(point[1].GetInt(), point[2].GetInt(), point[0].GetInt());
+		this->_vertices.push_back(this->newVertex(point[1].GetInt(), point[2].GetInt(), point[0].GetInt()));
 	}
 	if (first.HasMember("isClosed")) {
 		const auto &closed = first["isClosed"];
-		if (closed.IsBool() && closed.GetBool()) {
-			this->close();
-		}
+		// as close() does, ignores the flag for less than three vertices
+		this->_isClosed = closed.IsBool() && closed.GetBool() && this->_vertices.size() >= 3;
 	}
+	this->updateEdges();
+	this->addAllCrossings();
 
-	const auto list = this->edges();
-	const std::vector<Edge> edges(std::begin(list), std::end(list));
+	const auto &edges = this->edges();
 	const auto &crossings = first["crossings"];
 	if (!crossings.IsArray()) {
 		throw std::runtime_error("Crossings must be a list of objects");
@@ -99,11 +98,7 @@ rapidjson::Document Diagram::serialize() const {
 	doc.AddMember("name", caption, doc.GetAllocator());
 
 	rapidjson::Value vertices(rapidjson::kArrayType);
-	std::map<std::shared_ptr<Vertex>,std::size_t> nums;
-	int index = 0;
 	for (const auto &vertex : this->vertices()) {
-		nums[vertex] = index;
-		index += 1;
 		rapidjson::Value point(rapidjson::kArrayType);
 		point.PushBack((int)vertex->index, doc.GetAllocator());
 		point.PushBack(vertex->_x, doc.GetAllocator());
@@ -115,8 +110,8 @@ rapidjson::Document Diagram::serialize() const {
 	for (const auto &edge : this->edges()) {
 		for (const auto &crs : this->underCrossings(edge)) {
 			rapidjson::Value c(rapidjson::kObjectType);
-			c.AddMember("down", (int)nums[edge.start], doc.GetAllocator());
-			c.AddMember("up", (int)nums[crs.up.start], doc.GetAllocator());
+			c.AddMember("down", (int)edge.start->position, doc.GetAllocator());
+			c.AddMember("up", (int)crs.up.start->position, doc.GetAllocator());
 			crossings.PushBack(c, doc.GetAllocator());
 		}
 	}
@@ -14,7 +14,6 @@
  * limitations under the License.
  */
 
-#include <set>
 #include <vector>
 
 #include "Diagram.h"
@@ -22,24 +21,25 @@
 namespace KE::TwoD {
 
 bool Diagram::simplify(std::size_t depth) {
-	const auto list = this->edges();
-	const std::vector<Edge> edges(std::begin(list), std::end(list));
+	// a copy: removeVertex() rebuilds the edge list
+	const std::vector<Edge> edges = this->edges();
 
 	if (!this->isClosed() || depth == 0 || edges.size() <= 2 * depth) {
 		return false;
 	}
 
-	std::set<std::shared_ptr<Vertex>> crossings;
+	// edge i starts at vertex i
+	std::vector<bool> crossings(edges.size(), false);
 	for (const auto &edge : edges) {
 		for (const auto &crs : this->underCrossings(edge)) {
-			crossings.insert(crs.up.start);
-			crossings.insert(crs.down.start);
+			crossings[crs.up.start->position] = true;
+			crossings[crs.down.start->position] = true;
 		}
 	}
 
 	std::vector<bool> single_flags;
-	for (const auto &edge : edges) {
-		single_flags.push_back(crossings.find(edge.start) == crossings.end());
+	for (std::size_t index = 0; index < edges.size(); ++index) {
+		single_flags.push_back(!crossings[index]);
 	}
 	for (std::size_t i = 0; i < 2 * depth; ++i) {
 		single_flags.push_back(single_flags[i]);
@@ -20,12 +20,31 @@
 
 namespace KE::TwoD {
 
-std::shared_ptr<Diagram::Vertex> Diagram::addVertex(int x, int y) {
+std::size_t Diagram::newIndex() const {
 	std::size_t newIndex = 0;
 	for (const auto &v : this->_vertices) {
 		newIndex = std::max(newIndex, v->index + 1);
 	}
-	return this->addVertex(x, y, newIndex);
+	return newIndex;
+}
+
+std::shared_ptr<Diagram::Vertex> Diagram::newVertex(int x, int y, std::size_t index) {
+	auto vertex = std::make_shared<Vertex>(x, y, index);
+	vertex->id = this->slots.size();
+	this->slots.push_back(vertex.get());
+	this->crossingTable.emplace_back();
+	this->overTable.emplace_back();
+	return vertex;
+}
+
+void Diagram::releaseVertex(const Vertex &vertex) {
+	this->slots[vertex.id] = nullptr;
+	this->crossingTable[vertex.id].clear();
+	this->overTable[vertex.id].clear();
+}
+
+std::shared_ptr<Diagram::Vertex> Diagram::addVertex(int x, int y) {
+	return this->addVertex(x, y, this->newIndex());
 }
 
 std::shared_ptr<Diagram::Vertex> Diagram::addVertex(int x, int y, std::size_t index) {
@@ -33,45 +52,43 @@ std::shared_ptr<Diagram::Vertex> Diagram::addVertex(int x, int y, std::size_t in
 		return nullptr;
 	}
 
-	auto new_vertex = std::make_shared<Vertex>(x, y, index);
-	if (this->_vertices.empty()) {
-		this->_vertices.push_back(new_vertex);
-	} else {
-		std::shared_ptr<Vertex> end = this->_vertices.back();
-		this->_vertices.push_back(new_vertex);
-		const Edge new_edge(end, new_vertex);
-		for (const Edge &e : this->edges()) {
-			if (e.intersects(new_edge)) {
-				this->addCrossing(new_edge, e);
-				e.orderCrossings(e.start->crossings);
-			}
+	auto new_vertex = this->newVertex(x, y, index);
+	this->_vertices.push_back(new_vertex);
+	this->updateEdges();
+	if (this->_edges.empty()) {
+		return new_vertex;
+	}
+
+	const Edge &new_edge = this->_edges.back();
+	for (const Edge &e : this->_edges) {
+		if (e.intersects(new_edge)) {
+			this->addCrossing(new_edge, e);
 		}
 	}
 	return new_vertex;
 }
 
-std::shared_ptr<Diagram::Vertex> Diagram::addVertex(const Edge &edge, int x, int y) {
-	std::size_t newIndex = 0;
-	for (const auto &v : this->_vertices) {
-		newIndex = std::max(newIndex, v->index + 1);
-	}
-	auto new_vertex = std::make_shared<Vertex>(x, y, newIndex);
-	auto iter = std::find(this->_vertices.begin(), this->_vertices.end(), edge.end);
+std::shared_ptr<Diagram::Vertex> Diagram::addVertex(const Edge &split, int x, int y) {
+	// the argument might be an element of the edge list that is rebuilt below
+	const Edge edge = split;
+	auto new_vertex = this->newVertex(x, y, this->newIndex());
+	const auto iter = std::find(this->_vertices.begin(), this->_vertices.end(), edge.end);
 	this->_vertices.insert(iter, new_vertex);
+	this->updateEdges();
 
 	const Edge new1(edge.start, new_vertex);
 	const Edge new2(new_vertex, edge.end);
 
-	for (const Edge &e : this->edges()) {
+	for (const Edge &e : this->_edges) {
 		auto removed_crossing = this->getCrossing(edge, e);
 		this->removeCrossing(edge, e);
 
-		for (const Edge &new_edge : {new1, new2}) {
-			if (e.intersects(new_edge)) {
+		for (const Edge *new_edge : {&new1, &new2}) {
+			if (e.intersects(*new_edge)) {
 				if (removed_crossing && removed_crossing->up == e) {
-					this->addCrossing(e, new_edge);
+					this->addCrossing(e, *new_edge);
 				} else {
-					this->addCrossing(new_edge, e);
+					this->addCrossing(*new_edge, e);
 				}
 			}
 		}
@@ -81,24 +98,30 @@ std::shared_ptr<Diagram::Vertex> Diagram::addVertex(const Edge &edge, int x, int
 	return new_vertex;
 }
 
-void Diagram::removeVertex(const std::shared_ptr<Vertex> &vertex) {
+void Diagram::removeVertex(const std::shared_ptr<Vertex> &removed) {
+	// the argument might be an element of the vertex list that is changed below
+	const std::shared_ptr<Vertex> vertex = removed;
+	if (!this->contains(*vertex)) {
+		return;
+	}
+
 	std::shared_ptr<const Edge> removed1;
 	std::shared_ptr<const Edge> removed2;
-	for (const Edge &edge : this->edges()) {
-		if (edge.end == vertex) {
-			removed1 = std::make_shared<const Edge>(edge);
-		} else if (edge.start == vertex) {
-			removed2 = std::make_shared<const Edge>(edge);
-		}
+	if (const Edge *edge = this->edgeTo(*vertex)) {
+		removed1 = std::make_shared<const Edge>(*edge);
+	}
+	if (const Edge *edge = this->edgeFrom(*vertex)) {
+		removed2 = std::make_shared<const Edge>(*edge);
 	}
 	std::shared_ptr<const Edge> merged;
 	if (removed1 && removed2) {
 		merged = std::make_shared<const Edge>(removed1->start, removed2->end);
 	}
 
-	this->_vertices.remove(vertex);
+	this->_vertices.erase(this->_vertices.begin() + vertex->position);
+	this->updateEdges();
 
-	for (const Edge &edge : this->edges()) {
+	for (const Edge &edge : this->_edges) {
 		std::shared_ptr<Crossing> removed_crossing1;
 		if (removed1) {
 			removed_crossing1 = this->getCrossing(*removed1, edge);
@@ -120,6 +143,8 @@ void Diagram::removeVertex(const std::shared_ptr<Vertex> &vertex) {
 			this->addCrossing(*merged, edge);
 		}
 	}
+
+	this->releaseVertex(*vertex);
 }
 
 bool Diagram::moveVertex(const std::shared_ptr<Vertex> &vertex, int x, int y) {
@@ -127,17 +152,10 @@ bool Diagram::moveVertex(const std::shared_ptr<Vertex> &vertex, int x, int y) {
 
 	bool changesCrossings = false;
 
-	std::shared_ptr<const Edge> changed1;
-	std::shared_ptr<const Edge> changed2;
-	for (const Edge &edge : this->edges()) {
-		if (edge.end == vertex) {
-			changed1 = std::make_shared<const Edge>(edge);
-		} else if (edge.start == vertex) {
-			changed2 = std::make_shared<const Edge>(edge);
-		}
-	}
+	const Edge *changed1 = this->edgeTo(*vertex);
+	const Edge *changed2 = this->edgeFrom(*vertex);
 
-	for (const Edge &edge : this->edges()) {
+	for (const Edge &edge : this->_edges) {
 		auto changed_crossing1 = changed1 ? this->getCrossing(*changed1, edge) : nullptr;
 		auto changed_crossing2 = changed2 ? this->getCrossing(*changed2, edge) : nullptr;
 
@@ -171,6 +189,7 @@ bool Diagram::moveVertex(const std::shared_ptr<Vertex> &vertex, int x, int y) {
 		}
 	}
 
+	this->updateCrossings(vertex.get());
 	this->order();
 
 	return changesCrossings;
@@ -181,7 +200,7 @@ void Diagram::close() {
 		return;
 	}
 
-	const auto edges = this->edges();
+	const auto &edges = this->_edges;
 	if (edges.size() < 2) {
 		return;
 	}
@@ -193,10 +212,11 @@ void Diagram::close() {
 		}
 	}
 	this->_isClosed = true;
+	this->updateEdges();
 }
 
 void Diagram::removeEdge(const Edge &edge) {
-	const auto edges = this->edges();
+	const auto &edges = this->_edges;
 	if (edges.empty()) {
 		return;
 	}
@@ -206,7 +226,8 @@ void Diagram::removeEdge(const Edge &edge) {
 		if (loc == edges.end()) {
 			return;
 		}
-		std::list<std::shared_ptr<Vertex>> new_list;
+		std::vector<std::shared_ptr<Vertex>> new_list;
+		new_list.reserve(edges.size());
 		for (auto it = loc; it != edges.end(); ++it) {
 			new_list.push_back(it->end);
 		}
@@ -214,20 +235,28 @@ void Diagram::removeEdge(const Edge &edge) {
 			new_list.push_back(it->end);
 		}
 		// TODO: remove crossings
-		new_list.back()->crossings.clear();
+		this->crossingTable[edge.start->id].clear();
 		for (const auto &vertex : new_list) {
-			vertex->crossings.remove_if([edge](const Crossing &crossing) { return crossing.up == edge; });
+			auto &crossings = this->crossingTable[vertex->id];
+			crossings.erase(
+				std::remove_if(crossings.begin(), crossings.end(), [&edge](const Crossing &crossing) { return crossing.up == edge; }),
+				crossings.end()
+			);
 		}
 		this->_vertices.swap(new_list);
 		this->_isClosed = false;
+		this->updateEdges();
 	} else {
-		if (edge == edges.front()) {
-			this->removeVertex(edge.start);
-			if (edges.size() == 1) {
-				this->removeVertex(edge.end);
+		// the edge is copied: removeVertex() rebuilds the edge list
+		const Edge removed = edge;
+		const std::size_t size = edges.size();
+		if (removed == edges.front()) {
+			this->removeVertex(removed.start);
+			if (size == 1) {
+				this->removeVertex(removed.end);
 			}
-		} else if (edge == edges.back()) {
-			this->removeVertex(edge.end);
+		} else if (removed == edges.back()) {
+			this->removeVertex(removed.end);
 		}
 	}
 }
@@ -0,0 +1,454 @@
+/*
+ * Copyright (c) 1995-2021, Nikolay Pultsin <geometer@geometer.name>
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "EnergyKernel.h"
+#include "ThreadPool.h"
+
+namespace KE::ThreeD {
+
+namespace {
+
+const std::size_t CHUNK_SIZE = 64;
+const std::size_t LANES = PointArray::simdWidth;
+// число точек в неделимых группах вдоль узла
+const std::size_t LEAF_SIZE = 8;
+// Ниже этого числа точек векторизованная точная сумма быстрее
+// приближённой даже при tolerance = 0.1 (8_18 и 11_1, один поток).
+const std::size_t FAR_FIELD_ENERGY_MIN_SIZE = 10000;
+
+double squaredDistance(const Point &p0, const Point &p1) {
+	return (p1.x - p0.x) * (p1.x - p0.x) + (p1.y - p0.y) * (p1.y - p0.y) + (p1.z - p0.z) * (p1.z - p0.z);
+}
+
+}
+
+// Слагаемые градиента в p_i от взаимодействия с рёбрами p_jp_{j+1}.
+struct EnergyKernel::Term {
+	const double *__restrict px, *__restrict py, *__restrict pz;
+	const double *__restrict ex, *__restrict ey, *__restrict ez;
+	const double *__restrict len;
+	// p_i, сумма длин смежных с p_i рёбер и общее для всех слагаемых
+	// в p_i направление
+	double pix, piy, piz, lt, lx, ly, lz;
+
+	void operator()(std::size_t j, double &sx, double &sy, double &sz) const {
+		// Ищем ближайшую к p_i точку на ребре p_jp_{j+1}: p_j + tau * r,
+		// где tau = -xr / r2, ограниченное отрезком [0, 1].
+		double x = px[j] - pix;
+		double y = py[j] - piy;
+		double z = pz[j] - piz;
+		const double xr = x * ex[j] + y * ey[j] + z * ez[j];
+		const double t = - xr / (len[j] * len[j]);
+		// То же, что min(max(t, 0), 1), но без ветвлений.
+		const double tau = (fabs(t) - fabs(t - 1.0) + 1.0) / 2;
+
+		// Записываем в x, y, z вектор от p_i до ближайшей точки,
+		// а в x2 -- квадрат его длины.
+		x += tau * ex[j];
+		y += tau * ey[j];
+		z += tau * ez[j];
+		const double x2 = x * x + y * y + z * z;
+
+		this->add(len[j], x, y, z, x2, sx, sy, sz);
+	}
+
+	// Слагаемое от массы weight, находящейся в p_i + (x, y, z), x2 = x^2 + y^2 + z^2.
+	void add(double weight, double x, double y, double z, double x2, double &sx, double &sy, double &sz) const {
+		const double coef = weight / x2;
+		const double coef2 = coef * lt / x2;
+		sx += coef2 * x + coef * lx;
+		sy += coef2 * y + coef * ly;
+		sz += coef2 * z + coef * lz;
+	}
+
+	// Добавляет к суммам s[x|y|z] слагаемые для from <= j < to. Слагаемые
+	// накапливаются в LANES независимых суммах, чтобы цикл векторизовался.
+	void accumulate(std::size_t from, std::size_t to, double *__restrict sx, double *__restrict sy, double *__restrict sz) const {
+		std::size_t j = from;
+		for (; j + LANES <= to; j += LANES) {
+			for (std::size_t lane = 0; lane < LANES; ++lane) {
+				(*this)(j + lane, sx[lane], sy[lane], sz[lane]);
+			}
+		}
+		for (std::size_t lane = 0; j < to; ++j, ++lane) {
+			(*this)(j, sx[lane], sy[lane], sz[lane]);
+		}
+	}
+};
+
+void EnergyKernel::setMethod(Method method, double openingAngle) {
+	this->method = method;
+	this->openingAngle = openingAngle;
+}
+
+double EnergyKernel::gradient(const PointArray &points, std::vector<Vector> &delta, Util::ThreadPool &pool) {
+	const std::size_t size = points.size();
+
+	this->edges.resize(size);
+	this->lengths.resize(PointArray::paddedSize(size));
+	for (std::size_t i = 0; i < size; ++i) {
+		const std::size_t next = i == size - 1 ? 0 : i + 1;
+		const Vector edge(points[i], points[next]);
+		this->edges.set(i, Point(edge.x, edge.y, edge.z));
+		// Создаем массив расстояний между соседними точками.
+		this->lengths[i] = edge.length();
+	}
+
+	if (this->method == Method::farField) {
+		this->middles.resize(size);
+		for (std::size_t i = 0; i < size; ++i) {
+			const std::size_t next = i == size - 1 ? 0 : i + 1;
+			this->middles.set(i, Point(
+				(points.x()[i] + points.x()[next]) / 2,
+				(points.y()[i] + points.y()[next]) / 2,
+				(points.z()[i] + points.z()[next]) / 2
+			));
+		}
+		this->octree.build(this->middles, this->lengths.data());
+	}
+
+	delta.assign(size, Vector(0.0, 0.0, 0.0));
+
+	const std::size_t numberOfChunks = Util::ThreadPool::numberOfChunks(size, CHUNK_SIZE);
+	this->chunkMaxShifts.assign(numberOfChunks, 0.0);
+	pool.run(numberOfChunks, [&](std::size_t chunk) {
+		const std::size_t begin = chunk * CHUNK_SIZE;
+		const std::size_t end = std::min(begin + CHUNK_SIZE, size);
+		if (this->method == Method::farField) {
+			this->farFieldGradient(points, delta, begin, end);
+		} else {
+			this->exactGradient(points, delta, begin, end);
+		}
+
+		double max_shift = 0.0;
+		for (std::size_t i = begin; i < end; ++i) {
+			max_shift = std::max(max_shift, fabs(delta[i].x));
+			max_shift = std::max(max_shift, fabs(delta[i].y));
+			max_shift = std::max(max_shift, fabs(delta[i].z));
+		}
+		this->chunkMaxShifts[chunk] = max_shift;
+	});
+
+	// Находим максимум из длин (компонент) градиентов.
+	double max_shift = 0.0;
+	for (double shift : this->chunkMaxShifts) {
+		max_shift = std::max(max_shift, shift);
+	}
+	return max_shift;
+}
+
+EnergyKernel::Term EnergyKernel::term(const PointArray &points, std::size_t i) const {
+	const std::size_t prev = i ? i - 1 : points.size() - 1;
+	const double *ex = this->edges.x(), *ey = this->edges.y(), *ez = this->edges.z();
+	const double *len = this->lengths.data();
+	// Вычисляем общие коэффициенты для всех слагаемых в p_i.
+	const Vector local = Vector::linear(
+		Vector(ex[i], ey[i], ez[i]), - 1 / len[i],
+		Vector(ex[prev], ey[prev], ez[prev]), 1 / len[prev]
+	);
+	return Term {
+		points.x(), points.y(), points.z(), ex, ey, ez, len,
+		points.x()[i], points.y()[i], points.z()[i], len[i] + len[prev], local.x, local.y, local.z
+	};
+}
+
+void EnergyKernel::exactGradient(const PointArray &points, std::vector<Vector> &delta, std::size_t begin, std::size_t end) const {
+	const std::size_t size = points.size();
+
+	// Вычисляем вектор градиента в каждой вершине ломаной.
+	for (std::size_t i = begin; i < end; i++) {
+		const Term term = this->term(points, i);
+		double sx[LANES] = {0.0}, sy[LANES] = {0.0}, sz[LANES] = {0.0};
+		// Взаимодействие со всеми рёбрами, кроме p_{i-1}p_i и p_ip_{i+1}.
+		if (i == 0) {
+			term.accumulate(1, size - 1, sx, sy, sz);
+		} else {
+			term.accumulate(i + 1, size, sx, sy, sz);
+			term.accumulate(0, i - 1, sx, sy, sz);
+		}
+
+		Vector &delta_i = delta[i];
+		for (std::size_t k = 0; k < LANES; ++k) {
+			delta_i.x -= sx[k];
+			delta_i.y -= sy[k];
+			delta_i.z -= sz[k];
+		}
+	}
+}
+
+void EnergyKernel::farFieldGradient(const PointArray &points, std::vector<Vector> &delta, std::size_t begin, std::size_t end) const {
+	const std::size_t size = points.size();
+
+	for (std::size_t i = begin; i < end; i++) {
+		const std::size_t prev = i ? i - 1 : size - 1;
+		const Term term = this->term(points, i);
+		const Point pi = points[i];
+		double sx = 0.0, sy = 0.0, sz = 0.0;
+		// Далёкие группы рёбер заменяем их суммарной длиной, помещённой в
+		// центр масс середин рёбер. Смежные с p_i рёбра находятся на расстоянии
+		// не больше lt / 2, поэтому в такие группы не попадают.
+		this->octree.traverse(pi, this->openingAngle, term.lt / 2, [&](const Octree::Node &node) {
+			const double x = node.center.x - pi.x;
+			const double y = node.center.y - pi.y;
+			const double z = node.center.z - pi.z;
+			term.add(node.weight, x, y, z, x * x + y * y + z * z, sx, sy, sz);
+		}, [&](std::size_t j) {
+			if (j != i && j != prev) {
+				term(j, sx, sy, sz);
+			}
+		});
+
+		delta[i].x -= sx;
+		delta[i].y -= sy;
+		delta[i].z -= sz;
+	}
+}
+
+void EnergyKernel::prepareEnergy(const PointArray &points) {
+	const std::size_t size = points.size();
+
+	// Длины дуг от p_0 до p_i и до середины ребра p_ip_{i+1},
+	// суммы длин рёбер, смежных с p_i, и середины рёбер.
+	this->lengths.resize(PointArray::paddedSize(size));
+	for (std::size_t i = 0; i < size; ++i) {
+		const std::size_t next = i == size - 1 ? 0 : i + 1;
+		this->lengths[i] = Vector(points[i], points[next]).length();
+	}
+	this->arcs.resize(size);
+	this->middleArcs.resize(size);
+	this->weights.resize(size);
+	this->middles.resize(size);
+	double arc = 0.0;
+	for (std::size_t i = 0; i < size; ++i) {
+		const std::size_t prev = i ? i - 1 : size - 1;
+		const std::size_t next = i == size - 1 ? 0 : i + 1;
+		this->arcs[i] = arc;
+		this->middleArcs[i] = arc + this->lengths[i] / 2;
+		arc += this->lengths[i];
+		this->weights[i] = this->lengths[prev] + this->lengths[i];
+		this->middles.set(i, Point(
+			(points.x()[i] + points.x()[next]) / 2,
+			(points.y()[i] + points.y()[next]) / 2,
+			(points.z()[i] + points.z()[next]) / 2
+		));
+	}
+}
+
+double EnergyKernel::energy(const PointArray &points, Util::ThreadPool &pool) {
+	const std::size_t size = points.size();
+	this->prepareEnergy(points);
+
+	const std::size_t numberOfChunks = Util::ThreadPool::numberOfChunks(size, CHUNK_SIZE);
+	this->chunkSums.assign(numberOfChunks, 0.0);
+	pool.run(numberOfChunks, [&](std::size_t chunk) {
+		const std::size_t begin = chunk * CHUNK_SIZE;
+		this->chunkSums[chunk] = this->energyTerms(points, begin, std::min(begin + CHUNK_SIZE, size));
+	});
+
+	double value = 0.0;
+	for (double sum : this->chunkSums) {
+		value += sum;
+	}
+
+	value /= 2.3;
+	value -= 4;
+	return value;
+}
+
+double EnergyKernel::energyTerms(const PointArray &points, std::size_t begin, std::size_t end) const {
+	const std::size_t size = points.size();
+	const double len = this->arcs[size - 1] + this->lengths[size - 1];
+
+	const double *px = points.x(), *py = points.y(), *pz = points.z();
+	const double *mx = this->middles.x(), *my = this->middles.y(), *mz = this->middles.z();
+	const double *a = this->arcs.data(), *ma = this->middleArcs.data();
+	const double *e = this->lengths.data(), *w = this->weights.data();
+
+	// Расстояние вдоль узла (по более короткой дуге), то же, что min(l, len - l).
+	const auto arcDistance = [len](double l) { return (len - fabs(2 * l - len)) / 2; };
+
+	const auto vertexTerm = [=](std::size_t i, std::size_t j, double &sum) {
+		const double cx = px[j] - px[i];
+		const double cy = py[j] - py[i];
+		const double cz = pz[j] - pz[i];
+		const double d = arcDistance(a[j] - a[i]);
+		sum += w[i] * w[j] * (0.65 / (cx * cx + cy * cy + cz * cz) - 0.65 / (d * d));
+	};
+	const auto middleTerm = [=](std::size_t i, std::size_t j, double &sum) {
+		const double rx = mx[j] - mx[i];
+		const double ry = my[j] - my[i];
+		const double rz = mz[j] - mz[i];
+		const double d = arcDistance(ma[j] - ma[i]);
+		sum += e[i] * e[j] * (2 / (rx * rx + ry * ry + rz * rz) - 2 / (d * d));
+	};
+
+	double sums[LANES] = {0.0};
+
+	for (std::size_t i = begin; i < end; ++i) {
+		// Пары несмежных вершин p_i, p_j, j > i.
+		const std::size_t vertexEnd = i ? size : size - 1;
+		std::size_t j = i + 2;
+		for (; j + LANES <= vertexEnd; j += LANES) {
+			for (std::size_t lane = 0; lane < LANES; ++lane) {
+				vertexTerm(i, j + lane, sums[lane]);
+			}
+		}
+		for (std::size_t lane = 0; j < vertexEnd; ++j, ++lane) {
+			vertexTerm(i, j, sums[lane]);
+		}
+
+		// Пары середин рёбер.
+		j = i + 1;
+		for (; j + LANES <= size; j += LANES) {
+			for (std::size_t lane = 0; lane < LANES; ++lane) {
+				middleTerm(i, j + lane, sums[lane]);
+			}
+		}
+		for (std::size_t lane = 0; j < size; ++j, ++lane) {
+			middleTerm(i, j, sums[lane]);
+		}
+	}
+
+	double value = 0.0;
+	for (std::size_t lane = 0; lane < LANES; ++lane) {
+		value += sums[lane];
+	}
+	return value;
+}
+
+double EnergyKernel::farFieldEnergy(const PointArray &points, double tolerance, Util::ThreadPool &pool) {
+	const std::size_t size = points.size();
+	if (size < FAR_FIELD_ENERGY_MIN_SIZE) {
+		return this->energy(points, pool);
+	}
+	this->prepareEnergy(points);
+
+	this->octree.build(this->middles, this->lengths.data());
+	this->vertexOctree.build(points, this->weights.data());
+	this->weightSums.assign(size + 1, 0.0);
+	this->weightArcSums.assign(size + 1, 0.0);
+	this->lengthSums.assign(size + 1, 0.0);
+	this->lengthArcSums.assign(size + 1, 0.0);
+	for (std::size_t i = 0; i < size; ++i) {
+		this->weightSums[i + 1] = this->weightSums[i] + this->weights[i];
+		this->weightArcSums[i + 1] = this->weightArcSums[i] + this->weights[i] * this->arcs[i];
+		this->lengthSums[i + 1] = this->lengthSums[i] + this->lengths[i];
+		this->lengthArcSums[i + 1] = this->lengthArcSums[i] + this->lengths[i] * this->middleArcs[i];
+	}
+
+	// Группа заменяется массой в её центре масс, поэтому линейные члены
+	// разложения 1 / r^2 сокращаются. Вторая производная 1 / r^2 не больше
+	// 6 / r^4, так что если диаметр группы s меньше openingAngle * (расстояние
+	// до неё), то относительная ошибка не больше 3 a^2 (1 + a)^2, a = openingAngle.
+	const double openingAngle = (sqrt(1 + 4 * sqrt(tolerance / 3)) - 1) / 2;
+
+	const std::size_t numberOfChunks = Util::ThreadPool::numberOfChunks(size, CHUNK_SIZE);
+	this->chunkSums.assign(numberOfChunks, 0.0);
+	pool.run(numberOfChunks, [&](std::size_t chunk) {
+		const std::size_t begin = chunk * CHUNK_SIZE;
+		this->chunkSums[chunk] = this->farFieldEnergyTerms(points, openingAngle, begin, std::min(begin + CHUNK_SIZE, size));
+	});
+
+	double value = 0.0;
+	for (double sum : this->chunkSums) {
+		value += sum;
+	}
+
+	value /= 2.3;
+	value -= 4;
+	return value;
+}
+
+double EnergyKernel::farFieldEnergyTerms(const PointArray &points, double openingAngle, std::size_t begin, std::size_t end) const {
+	const std::size_t size = points.size();
+	const double len = this->arcs[size - 1] + this->lengths[size - 1];
+	const auto arcDistance = [len](double l) { return (len - fabs(2 * fabs(l) - len)) / 2; };
+
+	// Сумма weight_j / r_ij^2 по всем j, кроме i и (если adjacent) соседних с i.
+	const auto spaceSum = [&](const Octree &tree, const PointArray &centers, const double *weight, std::size_t i, bool adjacent) {
+		const std::size_t prev = i ? i - 1 : size - 1;
+		const std::size_t next = i == size - 1 ? 0 : i + 1;
+		const Point pi = centers[i];
+		// Соседние точки находятся на расстоянии не больше weights[i],
+		// поэтому в далёкие группы не попадают.
+		double sum = 0.0;
+		tree.traverse(pi, openingAngle, adjacent ? this->weights[i] : 0.0, [&](const Octree::Node &node) {
+			sum += node.weight / squaredDistance(pi, node.center);
+		}, [&](std::size_t j) {
+			if (j != i && !(adjacent && (j == prev || j == next))) {
+				sum += weight[j] / squaredDistance(pi, centers[j]);
+			}
+		});
+		return sum;
+	};
+
+	// То же для weight_j / d_ij^2, где d_ij -- расстояние вдоль узла. Группы --
+	// отрезки номеров [from, to), делящиеся пополам; их веса и центры
+	// берутся из префиксных сумм.
+	const auto arcSum = [&](const double *arc, const double *weight, const std::vector<double> &sums, const std::vector<double> &arcSums, std::size_t i, bool adjacent) {
+		const std::size_t prev = i ? i - 1 : size - 1;
+		const std::size_t next = i == size - 1 ? 0 : i + 1;
+		// Точка, противоположная i, где у d_ij излом.
+		const double antipode = arc[i] < len / 2 ? arc[i] + len / 2 : arc[i] - len / 2;
+		const auto excluded = [&](std::size_t from, std::size_t to) {
+			const auto inside = [from, to](std::size_t j) { return from <= j && j < to; };
+			return inside(i) || (adjacent && (inside(prev) || inside(next))) || (arc[from] <= antipode && antipode <= arc[to - 1]);
+		};
+		double sum = 0.0;
+		std::pair<std::size_t,std::size_t> stack[128];
+		std::size_t top = 0;
+		stack[top++] = std::make_pair(0, size);
+		while (top > 0) {
+			const auto [from, to] = stack[--top];
+			if (to - from > LEAF_SIZE && !excluded(from, to)) {
+				const double distance = std::min(arcDistance(arc[from] - arc[i]), arcDistance(arc[to - 1] - arc[i]));
+				if (arc[to - 1] - arc[from] < openingAngle * distance) {
+					const double total = sums[to] - sums[from];
+					const double d = arcDistance((arcSums[to] - arcSums[from]) / total - arc[i]);
+					sum += total / (d * d);
+					continue;
+				}
+			}
+			if (to - from > LEAF_SIZE) {
+				const std::size_t middle = (from + to) / 2;
+				stack[top++] = std::make_pair(from, middle);
+				stack[top++] = std::make_pair(middle, to);
+			} else {
+				for (std::size_t j = from; j < to; ++j) {
+					if (j != i && !(adjacent && (j == prev || j == next))) {
+						const double d = arcDistance(arc[j] - arc[i]);
+						sum += weight[j] / (d * d);
+					}
+				}
+			}
+		}
+		return sum;
+	};
+
+	// Сумма по упорядоченным парам, то есть удвоенная сумма по парам j > i.
+	double value = 0.0;
+	for (std::size_t i = begin; i < end; ++i) {
+		const double vertexSum = spaceSum(this->vertexOctree, points, this->weights.data(), i, true) - arcSum(this->arcs.data(), this->weights.data(), this->weightSums, this->weightArcSums, i, true);
+		const double middleSum = spaceSum(this->octree, this->middles, this->lengths.data(), i, false) - arcSum(this->middleArcs.data(), this->lengths.data(), this->lengthSums, this->lengthArcSums, i, false);
+		value += this->weights[i] * 0.65 * vertexSum + this->lengths[i] * 2 * middleSum;
+	}
+	return value / 2;
+}
+
+}
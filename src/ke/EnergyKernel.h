@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 1995-2021, Nikolay Pultsin <geometer@geometer.name>
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __KE_ENERGY_KERNEL_H__
+#define __KE_ENERGY_KERNEL_H__
+
+#include <vector>
+
+#include "Octree.h"
+#include "PointArray.h"
+
+namespace KE::Util {
+
+class ThreadPool;
+
+}
+
+namespace KE::ThreeD {
+
+class EnergyKernel {
+
+public:
+	enum class Method {
+		// all vertex-edge interactions, O(n^2)
+		exact,
+		// Barnes–Hut approximation of far edge groups, O(n log n)
+		farField
+	};
+
+private:
+	struct Term;
+
+private:
+	Method method;
+	double openingAngle;
+
+	// Edge vectors and lengths, in the same SoA layout as the points.
+	PointArray edges;
+	PointArray::Coordinates lengths;
+	std::vector<double> chunkMaxShifts;
+	// Edge middles and the octree over them, for the far-field method.
+	PointArray middles;
+	Octree octree;
+	// Arc lengths and vertex weights for the energy.
+	PointArray::Coordinates arcs, middleArcs, weights;
+	std::vector<double> chunkSums;
+	// For the far-field energy: the octree over the vertices and prefix
+	// sums of weights and weighted arcs, for vertices and edge middles.
+	Octree vertexOctree;
+	std::vector<double> weightSums, weightArcSums, lengthSums, lengthArcSums;
+
+public:
+	EnergyKernel() : method(Method::exact), openingAngle(0.5) {}
+
+	// Smaller opening angle means more accurate and slower far-field approximation.
+	void setMethod(Method method, double openingAngle = 0.5);
+
+	// Computes the energy gradient in every vertex of the closed polygon,
+	// stores it in delta, and returns the maximum of absolute values
+	// of the gradient components. The vertices are split between
+	// the pool threads; the result does not depend on the pool size.
+	double gradient(const PointArray &points, std::vector<Vector> &delta, Util::ThreadPool &pool);
+	// Computes the discrete Moebius energy of the closed polygon.
+	// Like gradient(), the result does not depend on the pool size.
+	double energy(const PointArray &points, Util::ThreadPool &pool);
+	// The same in O(n log n): groups of vertices (and edge middles) that
+	// are far from a vertex, in space or along the knot, are replaced by
+	// single masses. The relative error of every such replacement is at most
+	// tolerance, so the total error is at most tolerance times the sum of
+	// the absolute values of the far terms. Does not depend on the method.
+	// Below about 10000 points the exact energy() is faster even for
+	// tolerance 0.1, and is computed instead.
+	double farFieldEnergy(const PointArray &points, double tolerance, Util::ThreadPool &pool);
+
+private:
+	Term term(const PointArray &points, std::size_t i) const;
+	void exactGradient(const PointArray &points, std::vector<Vector> &delta, std::size_t begin, std::size_t end) const;
+	void farFieldGradient(const PointArray &points, std::vector<Vector> &delta, std::size_t begin, std::size_t end) const;
+	void prepareEnergy(const PointArray &points);
+	double energyTerms(const PointArray &points, std::size_t begin, std::size_t end) const;
+	double farFieldEnergyTerms(const PointArray &points, double openingAngle, std::size_t begin, std::size_t end) const;
+};
+
+}
+
+#endif /* __KE_ENERGY_KERNEL_H__ */
@@ -22,74 +22,47 @@
 
 namespace KE::ThreeD {
 
-Knot::Knot(const std::vector<Point> &points, const std::string &caption) : caption(caption), generation(1), lockCount(0) {
-	this->_points = points;
+Knot::Knot(const std::vector<Point> &points, const std::string &caption) : caption(caption), generation(1), lockCount(0), _lastStep {0.0, 0.0, 0, 0.0, false, false}, _convergence(ConvergenceMonitor::Reason::none), _numberOfMonitoredSteps(0) {
+	this->_points = PointArray(points);
 
-	double min = this->_points.front().distanceTo(this->_points.back());
+	double min = points.front().distanceTo(points.back());
 	double total = min;
-	for (std::size_t i = 1; i < this->_points.size(); ++i) {
-		const double dist = this->_points[i - 1].distanceTo(this->_points[i]);
+	for (std::size_t i = 1; i < points.size(); ++i) {
+		const double dist = points[i - 1].distanceTo(points[i]);
 		min = std::min(min, dist);
 		total += dist;
 	}
-	this->normalize(std::max(5 * this->_points.size(), 3 * (std::size_t)std::round(total / min)));
+	this->normalize(std::max(5 * points.size(), 3 * (std::size_t)std::round(total / min)));
 	this->center();
 }
 
 void Knot::normalize(std::size_t newNumberOfPoints) {
 	std::lock_guard<std::mutex> writeMethodGuard(this->writeMethodMutex);
+	this->publishPoints();
 	const auto snapshot = this->snapshot();
-	auto normalized = this->normalizedPoints(snapshot, newNumberOfPoints);
+	auto normalized = snapshot.points().uniform(newNumberOfPoints);
 
 	counting_lock guard(*this);
+	this->session.reset();
 	this->_points.swap(normalized);
 }
 
-std::vector<Point> Knot::normalizedPoints(const Snapshot &snapshot, std::size_t newNumberOfPoints) {
-	const auto &edgeLengths = snapshot.edgeLengths();
-	const double totalLength = snapshot.knotLength();
-	const double newEdgeLength = totalLength / newNumberOfPoints;
-
-	std::vector<Point> newPoints;
-	newPoints.reserve(newNumberOfPoints);
-
-	std::size_t v = 0;
-	double llen = edgeLengths[0];
-	double rest = llen;
-
-	for (std::size_t i = 0; i < newNumberOfPoints; i++) {
-		const auto nextV = v == snapshot.size() - 1 ? 0 : v + 1;
-
-		const Vector delta(snapshot[v], snapshot[nextV]);
-		Point pt(snapshot[v]);
-		pt.move(delta, 1 - rest / llen);
-		newPoints.push_back(pt);
-
-		rest -= newEdgeLength;
-		while (rest < 0) {
-			v = v == snapshot.size() - 1 ? 0 : v + 1;
-			llen = edgeLengths[v];
-			rest += llen;
-		}
-	}
-
-	return newPoints;
-}
-
 std::vector<Point> Knot::pointsFromDiagram(const TwoD::Diagram &diagram, std::size_t width, std::size_t height) {
 	std::vector<Point> points;
 
-	const auto edges = diagram.edges();
-	auto all_crossings = diagram.allCrossings();
+	const auto &edges = diagram.edges();
+	const auto &sequence = diagram.crossingSequence();
 
-	for (const auto &edge : edges) {
+	for (std::size_t index = 0; index < edges.size(); ++index) {
+		const auto &edge = edges[index];
 		const auto coords = edge.start->coords();
 		points.push_back(Point(
 			2.4 * coords.x / width - 1.2,
 			1.2 - 2.4 * coords.y / height,
 			0
 		));
-		for (const auto &crs : all_crossings[edge]) {
+		for (std::size_t i = sequence.offsets[index]; i < sequence.offsets[index + 1]; ++i) {
+			const auto &crs = sequence.crossings[i];
 			std::shared_ptr<TwoD::FloatPoint> current = crs.coords();
 			if (!current) {
 				continue;
@@ -17,6 +17,8 @@
 #ifndef __KNOT_H__
 #define __KNOT_H__
 
+#include <functional>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -24,7 +26,8 @@
 
 #include <rapidjson/document.h>
 
-#include "primitives.h"
+#include "PointArray.h"
+#include "SmoothingSession.h"
 
 namespace KE::TwoD {
 
@@ -41,30 +44,79 @@ public:
 
 	friend class Knot;
 
+	public:
+		// Function computing a value for the snapshot cache; nullptr means
+		// "no value" (e.g., the computation is cancelled) and is not stored.
+		typedef std::function<std::shared_ptr<const void>()> Computation;
+
+	private:
+		struct Entry {
+			// Held during the computation, so that the value is computed once.
+			std::mutex computing;
+			std::size_t version;
+			std::shared_ptr<const void> value;
+
+			Entry() : version(0) {}
+		};
+		struct Cache {
+			std::mutex mutex;
+			std::map<std::size_t, std::shared_ptr<Entry>> entries;
+		};
+		struct EdgeLengths {
+			std::vector<double> lengths;
+
+			EdgeLengths(const Snapshot &snapshot);
+		};
+
 	private:
 		const Knot &knot;
-		const std::shared_ptr<std::vector<Point>> points;
-		const std::shared_ptr<std::vector<double>> _edgeLengths;
+		const std::shared_ptr<const PointArray> _points;
+		const std::shared_ptr<Cache> cache;
 		const std::size_t generation;
 
 	private:
-		Snapshot(const Knot &knot, const std::vector<Point> &points);
+		Snapshot(const Knot &knot, const PointArray &points);
 
 	public:
 		bool isObsolete() const { return this->generation < this->knot.generation; }
 
-		const Point &operator[](std::size_t	index) const { return (*this->points)[index]; }
-		std::size_t size() const { return this->points->size(); }
+		Point operator[](std::size_t index) const { return (*this->_points)[index]; }
+		std::size_t size() const { return this->_points->size(); }
+		const PointArray &points() const { return *this->_points; }
 
 		std::size_t next(std::size_t index) const {
-			return index == this->points->size() - 1 ? 0 : index + 1;
+			return index == this->_points->size() - 1 ? 0 : index + 1;
 		}
 		std::size_t prev(std::size_t index) const {
-			return index ? index - 1 : this->points->size() - 1;
+			return index ? index - 1 : this->_points->size() - 1;
 		}
 
 		const std::vector<double> &edgeLengths() const;
 		double knotLength() const;
+
+		// A key for cachedValue(), unique in the process.
+		static std::size_t newKey();
+
+		// Data derived from the points (e.g., by the math computables),
+		// constructed as T(snapshot) on the first call and shared
+		// by all copies of the snapshot.
+		template<typename T>
+		std::shared_ptr<const T> cached() const {
+			static const std::size_t key = newKey();
+			return std::static_pointer_cast<const T>(this->cachedValue(key, 0, [this] {
+				return std::make_shared<const T>(*this);
+			}));
+		}
+
+		// The cache of the snapshot is shared by all its copies, and the latest
+		// snapshot of a knot is kept by the knot, so every value is computed
+		// at most once per knot generation. A value is stored together with
+		// the version it is computed for; a value with another version is
+		// obsolete. Computations run without the cache lock and may read
+		// other values (but must not depend on themselves).
+		std::shared_ptr<const void> cachedValue(std::size_t key, std::size_t version, const Computation &computation) const;
+		// The stored value, or nullptr if it is not computed yet; never blocks on a computation.
+		std::shared_ptr<const void> storedValue(std::size_t key, std::size_t version) const;
 	};
 
 private:
@@ -88,19 +140,20 @@ private:
 public:
 	static std::vector<Point> pointsFromDiagram(const TwoD::Diagram &diagram, std::size_t width, std::size_t height);
 
-private:
-	static std::vector<Point> normalizedPoints(const Snapshot &snapshot, std::size_t numberOfPoints);
-
 public:
 	std::string caption;
 
 private:
 	mutable std::recursive_mutex dataChangeMutex;
 	std::mutex writeMethodMutex;
-	std::vector<Point> _points;
+	PointArray _points;
 	volatile std::size_t generation;
 	mutable volatile std::size_t lockCount;
 	mutable std::shared_ptr<Snapshot> latest;
+	SmoothingSession session;
+	StepReport _lastStep;
+	ConvergenceMonitor::Reason _convergence;
+	std::size_t _numberOfMonitoredSteps;
 
 public:
 	Knot(const rapidjson::Document &doc);
@@ -109,7 +162,27 @@ public:
 
 	Snapshot snapshot() const;
 
-	void decreaseEnergy();
+	// 0 means the shared pool with a thread per hardware core.
+	void setNumberOfThreads(std::size_t numberOfThreads);
+	void setGradientMethod(EnergyKernel::Method method, double openingAngle = 0.5);
+	// nullptr means the default (gradient descent) optimizer.
+	void setOptimizer(const std::shared_ptr<Optimizer> &optimizer);
+	StepReport lastStep() const;
+	// The smoothing is monitored since the last change of the knot
+	// not by the smoothing (center(), setLength(), normalize()).
+	void setConvergenceTolerances(const ConvergenceMonitor::Tolerances &tolerances);
+	// The monitor's verdict after the last step, and the number of steps
+	// it is based on.
+	ConvergenceMonitor::Reason convergence() const;
+	std::size_t numberOfMonitoredSteps() const;
+
+	// Makes a smoothing step. With publish == false, the step is made
+	// on the private points of the smoothing session, and readers do not
+	// see it (and the generation is not changed) until publish().
+	void decreaseEnergy(bool publish = true);
+	// Makes the result of the unpublished smoothing steps visible
+	// and prepares the snapshot for the readers.
+	void publish();
 	void setLength(double);
 	void center();
 	void normalize(std::size_t numberOfPoints);
@@ -117,6 +190,8 @@ public:
 	rapidjson::Document serialize() const;
 
 private:
+	void publishPoints();
+
 	Knot(const Knot&) = delete;
 	Knot& operator = (const Knot&) = delete;
 };
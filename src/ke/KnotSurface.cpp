@@ -20,7 +20,36 @@
 
 namespace KE::GL {
 
-KnotSurface::KnotSurface(const ThreeD::KnotWrapper &knot, std::size_t numberOfPointsOnMeridian) : Surface(true, false), knot(knot) {
+namespace {
+
+// Two unit normals in every vertex; depend on the points only,
+// so they are shared by the meshes of all thicknesses and meridians.
+struct Frames {
+	std::vector<ThreeD::Vector> normal1, normal2;
+
+	Frames(const ThreeD::Knot::Snapshot &points) {
+		this->normal1.reserve(points.size());
+		this->normal2.reserve(points.size());
+		for (std::size_t i = 0; i < points.size(); ++i) {
+			ThreeD::Vector v(points[points.prev(i)], points[points.next(i)]);
+			v.normalize();
+
+			ThreeD::Vector norm1(0.0, - v.z, v.y);
+			if (fabs(v.y) < fabs(v.x)) {
+				norm1 = ThreeD::Vector(v.z, 0.0, - v.x);
+			}
+			ThreeD::Vector norm2 = v.vector_product(norm1);
+			norm1.normalize();
+			norm2.normalize();
+			this->normal1.push_back(norm1);
+			this->normal2.push_back(norm2);
+		}
+	}
+};
+
+}
+
+KnotSurface::KnotSurface(const ThreeD::KnotWrapper &knot, std::size_t numberOfPointsOnMeridian) : Surface(knot, true, false), knot(knot) {
 	this->setNumberOfPointsOnMeridian(numberOfPointsOnMeridian);
 }
 
@@ -50,34 +79,10 @@ void KnotSurface::setNumberOfPointsOnMeridian(std::size_t numberOfPointsOnMeridi
 	this->destroy();
 }
 
-bool KnotSurface::isObsolete() const {
-	return Surface::isObsolete() || !this->stored || this->stored->isObsolete();
-}
-
-void KnotSurface::calculate() const {
-	const auto points = this->knot.snapshot();
-	this->stored = std::make_shared<ThreeD::Knot::Snapshot>(points);
-
-	if (points.size() == 0) {
-		return;
-	}
-
-	std::vector<ThreeD::Vector> normal1, normal2;
-	/* Creating normal vector table */
-	for (std::size_t i = 0; i < points.size(); ++i) {
-		ThreeD::Vector v(points[points.prev(i)], points[points.next(i)]);
-		v.normalize();
-
-		ThreeD::Vector norm1(0.0, - v.z, v.y);
-		if (fabs(v.y) < fabs(v.x)) {
-			norm1 = ThreeD::Vector(v.z, 0.0, - v.x);
-		}
-		ThreeD::Vector norm2 = v.vector_product(norm1);
-		norm1.normalize();
-		norm2.normalize();
-		normal1.push_back(norm1);
-		normal2.push_back(norm2);
-	}
+void KnotSurface::calculate(const ThreeD::Knot::Snapshot &points, Mesh &mesh) const {
+	const auto frames = points.cached<Frames>();
+	const auto &normal1 = frames->normal1;
+	const auto &normal2 = frames->normal2;
 
 	std::vector<std::size_t> shift;
 	std::vector<double> scalars;
@@ -122,7 +127,7 @@ void KnotSurface::calculate() const {
 				);
 				ThreeD::Point new_point(points[ix]);
 				new_point.move(n, thickness);
-				addpoint(new_point, n);
+				addpoint(mesh, new_point, n);
 			}
 
 			j1 += shift[ix];
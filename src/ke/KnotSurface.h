@@ -30,7 +30,6 @@ private:
 	const ThreeD::KnotWrapper &knot;
 	std::vector<double> sines;
 	std::vector<double> cosines;
-	mutable std::shared_ptr<ThreeD::Knot::Snapshot> stored;
 
 public:
 	KnotSurface(const ThreeD::KnotWrapper &knot, std::size_t numberOfPointsOnMeridian);
@@ -39,11 +38,10 @@ public:
 	const Color &frontColor() const override;
 	const Color &backColor() const override;
 
-	bool isObsolete() const override;
 	bool isVisible() const override;
 
 private:
-	void calculate() const override;
+	void calculate(const ThreeD::Knot::Snapshot &snapshot, Mesh &mesh) const override;
 
 private:
 	KnotSurface(const KnotSurface&) = delete;
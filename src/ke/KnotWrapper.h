@@ -55,7 +55,13 @@ public:
 	Knot::Snapshot snapshot() const { return this->knot.snapshot(); }
 	const std::string &caption() const { return this->knot.caption; }
 
-	void decreaseEnergy() { this->knot.decreaseEnergy(); }
+	void decreaseEnergy(bool publish = true) { this->knot.decreaseEnergy(publish); }
+	void publish() { this->knot.publish(); }
+	StepReport lastStep() const { return this->knot.lastStep(); }
+	void setConvergenceTolerances(const ConvergenceMonitor::Tolerances &tolerances) { this->knot.setConvergenceTolerances(tolerances); }
+	ConvergenceMonitor::Reason convergence() const { return this->knot.convergence(); }
+	std::size_t numberOfMonitoredSteps() const { return this->knot.numberOfMonitoredSteps(); }
+	void setOptimizer(const std::shared_ptr<Optimizer> &optimizer) { this->knot.setOptimizer(optimizer); }
 	void setCaption(const std::string &caption) { this->knot.caption = caption; }
 	void setLength(double length) { this->knot.setLength(length); }
 	void center() { this->knot.center(); }
@@ -19,7 +19,7 @@
 
 namespace KE::ThreeD {
 
-Knot::Knot(const rapidjson::Document &doc) : generation(1), lockCount(0) {
+Knot::Knot(const rapidjson::Document &doc) : generation(1), lockCount(0), _lastStep {0.0, 0.0, 0, 0.0, false, false}, _convergence(ConvergenceMonitor::Reason::none), _numberOfMonitoredSteps(0) {
 	if (doc.IsNull()) {
 		throw std::runtime_error("The file is not in JSON format");
 	}
@@ -45,13 +45,15 @@ Knot::Knot(const rapidjson::Document &doc) : generation(1), lockCount(0) {
 	if (!points.IsArray() || points.Size() < 3) {
 		throw std::runtime_error("Points format incorrect: expected a list of at least three elements");
 	}
+	std::vector<Point> pts;
 	for (rapidjson::SizeType i = 0; i < points.Size(); ++i) {
 		const auto &point = points[i];
 		if (!point.IsArray() || point.Size() != 3 || !point[0].IsNumber() || !point[1].IsNumber() || !point[2].IsNumber()) {
 			throw std::runtime_error("Each point must be an array of three integers");
 		}
-		this->_points.push_back(Point(point[0].GetDouble(), point[1].GetDouble(), point[2].GetDouble()));
+		pts.push_back(Point(point[0].GetDouble(), point[1].GetDouble(), point[2].GetDouble()));
 	}
+	this->_points = PointArray(pts);
 }
 
 rapidjson::Document Knot::serialize() const {
@@ -14,41 +14,96 @@
  * limitations under the License.
  */
 
+#include <atomic>
 #include <numeric>
 
 #include "Knot.h"
 
 namespace KE::ThreeD {
 
-namespace {
+// Последний снимок хранится в слоте shared_ptr. atomic_load/atomic_store
+// для shared_ptr в libstdc++ берут короткий мьютекс из внутреннего пула,
+// так что чтение не свободно от блокировок, но не ждёт dataChangeMutex,
+// пока снимок не устарел. Устаревший снимок заменяется под dataChangeMutex;
+// слот перепроверяется под ним, чтобы два потока не построили по снимку
+// (каждый со своим кэшем) для одного поколения.
+Knot::Snapshot Knot::snapshot() const {
+	const auto isCurrent = [this](const std::shared_ptr<Snapshot> &snapshot) {
+		return this->lockCount == 0 && snapshot && snapshot->generation == this->generation;
+	};
+	auto latest = std::atomic_load(&this->latest);
+	if (!isCurrent(latest)) {
+		std::lock_guard<std::recursive_mutex> guard(this->dataChangeMutex);
+		latest = std::atomic_load(&this->latest);
+		if (!isCurrent(latest)) {
+			latest = std::shared_ptr<Snapshot>(new Snapshot(*this, this->_points));
+			std::atomic_store(&this->latest, latest);
+		}
+	}
+	return *latest;
+}
 
-std::mutex snapshotMutex;
+Knot::Snapshot::Snapshot(const Knot &knot, const PointArray &points) : knot(knot), _points(new PointArray(points)), cache(new Cache), generation(knot.generation) {
+}
 
+std::size_t Knot::Snapshot::newKey() {
+	static std::atomic<std::size_t> counter(0);
+	return counter++;
 }
 
-Knot::Snapshot Knot::snapshot() const {
-	if (this->lockCount > 0 || !this->latest || this->latest->generation != this->generation) {
-		std::lock_guard<std::recursive_mutex> guard(this->dataChangeMutex);
-		this->latest = std::shared_ptr<Snapshot>(new Snapshot(*this, this->_points));
+// Мьютекс кэша защищает только таблицу и значения; само вычисление идёт
+// под мьютексом записи, поэтому другие записи (в том числе те, от которых
+// зависит вычисляемая) доступны в это время.
+std::shared_ptr<const void> Knot::Snapshot::cachedValue(std::size_t key, std::size_t version, const Computation &computation) const {
+	std::shared_ptr<Entry> entry;
+	{
+		std::lock_guard<std::mutex> guard(this->cache->mutex);
+		auto &slot = this->cache->entries[key];
+		if (!slot) {
+			slot = std::make_shared<Entry>();
+		}
+		if (slot->value && slot->version == version) {
+			return slot->value;
+		}
+		entry = slot;
 	}
-	return *this->latest;
+
+	std::lock_guard<std::mutex> computing(entry->computing);
+	{
+		std::lock_guard<std::mutex> guard(this->cache->mutex);
+		if (entry->value && entry->version == version) {
+			return entry->value;
+		}
+	}
+	const auto value = computation();
+	if (value) {
+		std::lock_guard<std::mutex> guard(this->cache->mutex);
+		entry->value = value;
+		entry->version = version;
+	}
+	return value;
+}
+
+std::shared_ptr<const void> Knot::Snapshot::storedValue(std::size_t key, std::size_t version) const {
+	std::lock_guard<std::mutex> guard(this->cache->mutex);
+	const auto iterator = this->cache->entries.find(key);
+	if (iterator == this->cache->entries.end() || iterator->second->version != version) {
+		return nullptr;
+	}
+	return iterator->second->value;
 }
 
-Knot::Snapshot::Snapshot(const Knot &knot, const std::vector<Point> &points) : knot(knot), points(new std::vector<Point>(points)), _edgeLengths(new std::vector<double>), generation(knot.generation) {
+Knot::Snapshot::EdgeLengths::EdgeLengths(const Snapshot &snapshot) {
+	this->lengths.reserve(snapshot.size());
+	for (std::size_t i = 1; i < snapshot.size(); ++i) {
+		this->lengths.push_back(snapshot[i].distanceTo(snapshot[i - 1]));
+	}
+	this->lengths.push_back(snapshot[snapshot.size() - 1].distanceTo(snapshot[0]));
 }
 
+// Длины хранятся в кэше снимка, пока жива хотя бы одна его копия.
 const std::vector<double> &Knot::Snapshot::edgeLengths() const {
-	if (this->_edgeLengths->empty()) {
-		std::lock_guard<std::mutex> guard(snapshotMutex);
-		if (this->_edgeLengths->empty()) {
-			this->_edgeLengths->reserve(this->size());
-			for (std::size_t i = 1; i < this->size(); ++i) {
-				this->_edgeLengths->push_back((*this)[i].distanceTo((*this)[i - 1]));
-			}
-			this->_edgeLengths->push_back((*this)[this->size() - 1].distanceTo((*this)[0]));
-		}
-	}
-	return *this->_edgeLengths;
+	return this->cached<EdgeLengths>()->lengths;
 }
 
 double Knot::Snapshot::knotLength() const {
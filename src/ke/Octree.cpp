@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 1995-2021, Nikolay Pultsin <geometer@geometer.name>
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+
+#include "Octree.h"
+
+namespace KE::ThreeD {
+
+namespace {
+
+const int MAX_DEPTH = 48;
+
+}
+
+void Octree::build(const PointArray &points, const double *weights, std::size_t maxLeafSize) {
+	this->_nodes.clear();
+	this->_indices.resize(points.size());
+	for (std::size_t i = 0; i < points.size(); ++i) {
+		this->_indices[i] = i;
+	}
+	if (points.empty()) {
+		return;
+	}
+	this->buildNode(points, weights, 0, points.size(), std::max(maxLeafSize, (std::size_t)1), 0);
+}
+
+std::size_t Octree::buildNode(const PointArray &points, const double *weights, std::size_t begin, std::size_t end, std::size_t maxLeafSize, int depth) {
+	const std::size_t index = this->_nodes.size();
+	this->_nodes.push_back(Node());
+
+	const double *coords[3] = {points.x(), points.y(), points.z()};
+	Node node;
+	double weight = 0.0;
+	double center[3] = {0.0, 0.0, 0.0};
+	for (int axis = 0; axis < 3; ++axis) {
+		node.min[axis] = coords[axis][this->_indices[begin]];
+		node.max[axis] = node.min[axis];
+	}
+	for (std::size_t k = begin; k < end; ++k) {
+		const std::size_t i = this->_indices[k];
+		for (int axis = 0; axis < 3; ++axis) {
+			node.min[axis] = std::min(node.min[axis], coords[axis][i]);
+			node.max[axis] = std::max(node.max[axis], coords[axis][i]);
+			center[axis] += weights[i] * coords[axis][i];
+		}
+		weight += weights[i];
+	}
+	node.center = Point(center[0] / weight, center[1] / weight, center[2] / weight);
+	node.weight = weight;
+	node.begin = begin;
+	node.end = end;
+	std::fill(std::begin(node.children), std::end(node.children), 0);
+	node.isLeaf = end - begin <= maxLeafSize || depth == MAX_DEPTH;
+
+	if (!node.isLeaf) {
+		// Делим узел на октанты относительно центра ограничивающего параллелепипеда.
+		std::size_t bounds[9];
+		bounds[0] = begin;
+		bounds[8] = end;
+		const auto split = [&](std::size_t from, std::size_t to, int axis) {
+			const double middle = (node.min[axis] + node.max[axis]) / 2;
+			return std::partition(this->_indices.begin() + from, this->_indices.begin() + to, [&](std::size_t i) {
+				return coords[axis][i] < middle;
+			}) - this->_indices.begin();
+		};
+		bounds[4] = split(bounds[0], bounds[8], 0);
+		for (int half = 0; half < 2; ++half) {
+			bounds[4 * half + 2] = split(bounds[4 * half], bounds[4 * half + 4], 1);
+			for (int quarter = 0; quarter < 2; ++quarter) {
+				const int from = 4 * half + 2 * quarter;
+				bounds[from + 1] = split(bounds[from], bounds[from + 2], 2);
+			}
+		}
+		for (int octant = 0; octant < 8; ++octant) {
+			if (bounds[octant] < bounds[octant + 1]) {
+				node.children[octant] = this->buildNode(points, weights, bounds[octant], bounds[octant + 1], maxLeafSize, depth + 1);
+			}
+		}
+	}
+
+	this->_nodes[index] = node;
+	return index;
+}
+
+}
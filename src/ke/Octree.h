@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 1995-2021, Nikolay Pultsin <geometer@geometer.name>
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __KE_OCTREE_H__
+#define __KE_OCTREE_H__
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "PointArray.h"
+
+namespace KE::ThreeD {
+
+// Octree over weighted points, used for far-field (Barnes–Hut) approximations
+// of pairwise sums. The node buffers are reused between build() calls.
+class Octree {
+
+public:
+	struct Node {
+		// bounding box of the points in the node
+		double min[3], max[3];
+		// weighted center and total weight of the points
+		Point center;
+		double weight;
+		// range of the node points in indices()
+		std::size_t begin, end;
+		// child node indices; 0 means no child (the root is never a child)
+		std::size_t children[8];
+		bool isLeaf;
+
+		Node() : center(0.0, 0.0, 0.0) {}
+
+		double diagonal() const {
+			return sqrt(
+				(this->max[0] - this->min[0]) * (this->max[0] - this->min[0]) +
+				(this->max[1] - this->min[1]) * (this->max[1] - this->min[1]) +
+				(this->max[2] - this->min[2]) * (this->max[2] - this->min[2])
+			);
+		}
+		double distanceTo(const Point &point) const {
+			const double dx = std::max(std::max(this->min[0] - point.x, point.x - this->max[0]), 0.0);
+			const double dy = std::max(std::max(this->min[1] - point.y, point.y - this->max[1]), 0.0);
+			const double dz = std::max(std::max(this->min[2] - point.z, point.z - this->max[2]), 0.0);
+			return sqrt(dx * dx + dy * dy + dz * dz);
+		}
+	};
+
+private:
+	std::vector<Node> _nodes;
+	std::vector<std::size_t> _indices;
+
+public:
+	// Builds the tree for the first size points; weights must be positive.
+	void build(const PointArray &points, const double *weights, std::size_t maxLeafSize = 8);
+
+	const std::vector<Node> &nodes() const { return this->_nodes; }
+	const std::vector<std::size_t> &indices() const { return this->_indices; }
+
+	// Walks the tree for the given point. A node is treated as a single
+	// far-away mass, far(node), if its diagonal is less than openingAngle
+	// times the distance from the point to its box, and that distance
+	// exceeds minDistance. Points of the remaining leaves are passed
+	// one-by-one to near(index). Uses its own stack, so it is safe to call
+	// from several threads at once.
+	template<typename Far, typename Near>
+	void traverse(const Point &point, double openingAngle, double minDistance, Far far, Near near) const {
+		if (this->_nodes.empty()) {
+			return;
+		}
+		std::size_t stack[8 * 64];
+		std::size_t top = 0;
+		stack[top++] = 0;
+		while (top > 0) {
+			const Node &node = this->_nodes[stack[--top]];
+			const double distance = node.distanceTo(point);
+			if (!node.isLeaf && distance > minDistance && node.diagonal() < openingAngle * distance) {
+				far(node);
+			} else if (node.isLeaf) {
+				for (std::size_t k = node.begin; k < node.end; ++k) {
+					near(this->_indices[k]);
+				}
+			} else {
+				for (std::size_t child : node.children) {
+					if (child) {
+						stack[top++] = child;
+					}
+				}
+			}
+		}
+	}
+
+private:
+	std::size_t buildNode(const PointArray &points, const double *weights, std::size_t begin, std::size_t end, std::size_t maxLeafSize, int depth);
+};
+
+}
+
+#endif /* __KE_OCTREE_H__ */
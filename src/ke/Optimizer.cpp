@@ -0,0 +1,379 @@
+/*
+ * Copyright (c) 1995-2021, Nikolay Pultsin <geometer@geometer.name>
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "Optimizer.h"
+
+namespace KE::ThreeD {
+
+namespace {
+
+// Шаги -- в долях средней длины ребра.
+const double INITIAL_STEP_RATIO = 0.2;
+const double MIN_STEP_RATIO = 1e-6;
+const double MAX_STEP_RATIO = 0.5;
+const std::size_t MAX_NUMBER_OF_TRIALS = 8;
+const double SOBOLEV_INITIAL_STEP_RATIO = 1.0;
+const double SOBOLEV_MAX_STEP_RATIO = 4.0;
+const std::size_t SOBOLEV_RETRY_INTERVAL = 16;
+
+double dot(const std::vector<Vector> &v0, const std::vector<Vector> &v1) {
+	double sum = 0.0;
+	for (std::size_t i = 0; i < v0.size(); ++i) {
+		sum += v0[i].scalar_product(v1[i]);
+	}
+	return sum;
+}
+
+void add(std::vector<Vector> &v0, const std::vector<Vector> &v1, double coef) {
+	for (std::size_t i = 0; i < v0.size(); ++i) {
+		v0[i].add(v1[i], coef);
+	}
+}
+
+}
+
+std::shared_ptr<Optimizer> Optimizer::create(Method method) {
+	switch (method) {
+		case Method::lineSearch:
+			return std::make_shared<LineSearch>();
+		case Method::lbfgs:
+			return std::make_shared<LBFGS>();
+		case Method::sobolev:
+			return std::make_shared<SobolevGradient>();
+		case Method::multigrid:
+			return std::make_shared<Multigrid>();
+		default:
+			return std::make_shared<GradientDescent>();
+	}
+}
+
+void Optimizer::project(PointArray &points, double totalLength) {
+	points.scale(totalLength / points.closedLength());
+	points.moveAll(points.sum(), - 1.0 / points.size());
+}
+
+double Optimizer::maxComponent(const std::vector<Vector> &vectors) {
+	double max = 0.0;
+	for (const auto &v : vectors) {
+		max = std::max(max, fabs(v.x));
+		max = std::max(max, fabs(v.y));
+		max = std::max(max, fabs(v.z));
+	}
+	return max;
+}
+
+double Optimizer::backtrack(PointArray &points, const std::vector<Vector> &direction, double coef, double energy, double totalLength, EnergyKernel &kernel, Util::ThreadPool &pool, StepReport &report) {
+	for (std::size_t trial = 1; trial <= MAX_NUMBER_OF_TRIALS; ++trial) {
+		this->candidate = points;
+		for (std::size_t i = 0; i < points.size(); i++) {
+			this->candidate.move(i, direction[i], coef);
+		}
+		project(this->candidate, totalLength);
+		// Следующая итерация всё равно расставит точки равномерно; оцениваем
+		// энергию уже после этого, иначе принятый шаг может её увеличить.
+		this->candidate.uniform(this->candidate.size(), this->resampled);
+		this->candidate.swap(this->resampled);
+
+		const double candidateEnergy = kernel.energy(this->candidate, pool);
+		report.numberOfTrials = trial;
+		if (candidateEnergy < energy) {
+			points.swap(this->candidate);
+			report.energy = candidateEnergy;
+			report.hasEnergy = true;
+			return coef;
+		}
+		coef /= 2;
+	}
+
+	report.energy = energy;
+	report.hasEnergy = true;
+	return 0.0;
+}
+
+bool GradientDescent::step(PointArray &points, double totalLength, EnergyKernel &kernel, Util::ThreadPool &pool, StepReport &report) {
+	const double max_shift = kernel.gradient(points, this->delta, pool);
+	report.gradientNorm = max_shift;
+	report.hasGradientNorm = true;
+
+	// Вычисляем коэффициент, на который нужно домножить градиент.
+	double coeff = totalLength * totalLength / points.size() / points.size() / 10.0;
+	if (coeff > totalLength / points.size() / max_shift / 5.0)
+		coeff = totalLength / points.size() / max_shift / 5.0;
+
+	// Делаем сдвиг в направлении градиента.
+	for (std::size_t i = 0; i < points.size(); i++) {
+		points.move(i, this->delta[i], coeff);
+	}
+
+	project(points, totalLength);
+	report.stepSize = coeff * max_shift * points.size() / totalLength;
+	return true;
+}
+
+LineSearch::LineSearch(double initialStepRatio, double maxStepRatio) : initialStepRatio(initialStepRatio), maxStepRatio(maxStepRatio), stepRatio(initialStepRatio) {
+}
+
+void LineSearch::reset() {
+	this->stepRatio = this->initialStepRatio;
+}
+
+bool LineSearch::step(PointArray &points, double totalLength, EnergyKernel &kernel, Util::ThreadPool &pool, StepReport &report) {
+	report.gradientNorm = kernel.gradient(points, this->delta, pool);
+	report.hasGradientNorm = true;
+	return this->search(points, this->delta, kernel.energy(points, pool), totalLength, kernel, pool, report);
+}
+
+// Возвратный поиск шага по энергии Мёбиуса: начинаем с шага, принятого
+// на прошлой итерации, и уменьшаем его вдвое, пока энергия не уменьшится.
+// Если первый же шаг удачен, на следующей итерации пробуем вдвое больший.
+bool LineSearch::search(PointArray &points, const std::vector<Vector> &direction, double energy, double totalLength, EnergyKernel &kernel, Util::ThreadPool &pool, StepReport &report) {
+	// Коэффициент, при котором самая быстрая вершина сдвигается
+	// на среднюю длину ребра.
+	const double unit = totalLength / points.size() / maxComponent(direction);
+
+	const double coef = this->backtrack(points, direction, this->stepRatio * unit, energy, totalLength, kernel, pool, report);
+	if (coef == 0.0) {
+		this->stepRatio = std::max(this->stepRatio / (1 << MAX_NUMBER_OF_TRIALS), MIN_STEP_RATIO);
+		return false;
+	}
+
+	report.stepSize = coef / unit;
+	this->stepRatio = report.numberOfTrials == 1 ? std::min(2 * report.stepSize, this->maxStepRatio) : report.stepSize;
+	return true;
+}
+
+SobolevGradient::SobolevGradient(double order) : sobolevOperator(order), sobolevSearch(SOBOLEV_INITIAL_STEP_RATIO, SOBOLEV_MAX_STEP_RATIO), gradientIterations(0) {
+}
+
+void SobolevGradient::reset() {
+	this->sobolevSearch.reset();
+	this->gradientSearch.reset();
+	this->gradientIterations = 0;
+}
+
+bool SobolevGradient::step(PointArray &points, double totalLength, EnergyKernel &kernel, Util::ThreadPool &pool, StepReport &report) {
+	report.gradientNorm = kernel.gradient(points, this->delta, pool);
+	report.hasGradientNorm = true;
+	const double energy = kernel.energy(points, pool);
+
+	std::size_t numberOfTrials = 0;
+	if (this->gradientIterations == 0) {
+		// Если найденное направление не ведёт вниз, сразу переходим
+		// к обычным градиентным шагам.
+		if (this->computeDirection(points, pool)) {
+			if (this->sobolevSearch.search(points, this->direction, energy, totalLength, kernel, pool, report)) {
+				return true;
+			}
+			numberOfTrials = report.numberOfTrials;
+		}
+		this->sobolevSearch.reset();
+		this->gradientIterations = SOBOLEV_RETRY_INTERVAL;
+	}
+
+	--this->gradientIterations;
+	const bool moved = this->gradientSearch.search(points, this->delta, energy, totalLength, kernel, pool, report);
+	report.numberOfTrials += numberOfTrials;
+	return moved;
+}
+
+bool SobolevGradient::computeDirection(const PointArray &points, Util::ThreadPool &pool) {
+	this->sobolevOperator.build(points, pool);
+	this->sobolevOperator.solve(this->delta, this->direction, pool);
+
+	// Касательная составляющая только перераспределяет точки вдоль кривой,
+	// что на следующей итерации всё равно отменяется; убираем её. Сдвиг
+	// узла как целого энергию не меняет, а обращённым оператором почти
+	// не подавляется; его тоже убираем, чтобы он не ограничивал шаг.
+	const std::size_t size = points.size();
+	Vector mean(0.0, 0.0, 0.0);
+	for (std::size_t i = 0; i < size; ++i) {
+		Vector tangent(points[i ? i - 1 : size - 1], points[i == size - 1 ? 0 : i + 1]);
+		tangent.normalize();
+		Vector &v = this->direction[i];
+		v.add(tangent, - v.scalar_product(tangent));
+		mean.add(v, 1.0 / size);
+	}
+	for (auto &v : this->direction) {
+		v.add(mean, -1.0);
+	}
+
+	// Оператор с приближённым дальним полем несимметричен, а решение
+	// приближённое, так что спуск по найденному направлению не гарантирован.
+	return dot(this->direction, this->delta) > 0.0;
+}
+
+LBFGS::LBFGS(std::size_t historySize) : historySize(historySize), history(historySize + 1), numberOfCorrections(0) {
+}
+
+void LBFGS::reset() {
+	this->numberOfCorrections = 0;
+	this->previousPoints.resize(0);
+}
+
+// Запоминает пару (s, y) = (сдвиг точек, изменение градиента) с прошлой
+// итерации. Градиент хранится со знаком минус (delta), поэтому y = delta' - delta.
+// Пары, нарушающие условие кривизны s * y > 0, пропускаются; самая старая
+// пара вытесняется только тогда, когда новая действительно сохраняется.
+void LBFGS::addCorrection(const PointArray &points) {
+	if (this->previousPoints.size() != points.size()) {
+		return;
+	}
+
+	// Новая пара собирается в запасной ячейке за последней сохранённой.
+	Correction &correction = this->history[this->numberOfCorrections];
+	correction.s.resize(points.size(), Vector(0.0, 0.0, 0.0));
+	correction.y.resize(points.size(), Vector(0.0, 0.0, 0.0));
+	for (std::size_t i = 0; i < points.size(); ++i) {
+		correction.s[i] = Vector(this->previousPoints[i], points[i]);
+		correction.y[i] = Vector::linear(this->previousDelta[i], 1.0, this->delta[i], -1.0);
+	}
+	const double sy = dot(correction.s, correction.y);
+	if (sy > 1e-10 * sqrt(dot(correction.s, correction.s) * dot(correction.y, correction.y))) {
+		correction.rho = 1.0 / sy;
+		if (this->numberOfCorrections == this->historySize) {
+			std::rotate(this->history.begin(), this->history.begin() + 1, this->history.end());
+		} else {
+			++this->numberOfCorrections;
+		}
+	}
+}
+
+// Двухпроходная рекурсия L-BFGS: direction = H * delta, где H --
+// приближение к обратной матрице Гессе, построенное по истории.
+void LBFGS::computeDirection() {
+	this->direction = this->delta;
+	this->alpha.resize(this->numberOfCorrections);
+	for (std::size_t k = this->numberOfCorrections; k-- > 0; ) {
+		const Correction &correction = this->history[k];
+		this->alpha[k] = correction.rho * dot(correction.s, this->direction);
+		add(this->direction, correction.y, - this->alpha[k]);
+	}
+
+	const Correction &last = this->history[this->numberOfCorrections - 1];
+	const double gamma = 1.0 / last.rho / dot(last.y, last.y);
+	for (auto &v : this->direction) {
+		v.x *= gamma;
+		v.y *= gamma;
+		v.z *= gamma;
+	}
+
+	for (std::size_t k = 0; k < this->numberOfCorrections; ++k) {
+		const Correction &correction = this->history[k];
+		const double beta = correction.rho * dot(correction.y, this->direction);
+		add(this->direction, correction.s, this->alpha[k] - beta);
+	}
+}
+
+bool LBFGS::step(PointArray &points, double totalLength, EnergyKernel &kernel, Util::ThreadPool &pool, StepReport &report) {
+	const double max_shift = kernel.gradient(points, this->delta, pool);
+	report.gradientNorm = max_shift;
+	report.hasGradientNorm = true;
+	const double edge = totalLength / points.size();
+	this->addCorrection(points);
+
+	// Без истории (или если направление не ведёт вниз) делаем шаг по
+	// градиенту, иначе -- квазиньютоновский шаг длины 1. В обоих случаях
+	// ни одна вершина не сдвигается больше, чем на MAX_STEP_RATIO рёбер.
+	double coef = 0.0;
+	if (this->numberOfCorrections > 0) {
+		this->computeDirection();
+		if (dot(this->direction, this->delta) > 0.0) {
+			coef = std::min(1.0, MAX_STEP_RATIO * edge / maxComponent(this->direction));
+		} else {
+			this->numberOfCorrections = 0;
+		}
+	}
+	if (this->numberOfCorrections == 0) {
+		this->direction = this->delta;
+		coef = INITIAL_STEP_RATIO * edge / max_shift;
+	}
+
+	this->previousPoints = points;
+	this->previousDelta = this->delta;
+
+	const double energy = kernel.energy(points, pool);
+	coef = this->backtrack(points, this->direction, coef, energy, totalLength, kernel, pool, report);
+	if (coef == 0.0) {
+		this->reset();
+		return false;
+	}
+
+	report.stepSize = coef * maxComponent(this->direction) / edge;
+	return true;
+}
+
+Multigrid::Multigrid(Method levelMethod, std::size_t coarsestSize, std::size_t iterationsPerLevel) : levelOptimizer(create(levelMethod)), coarsestSize(coarsestSize), iterationsPerLevel(iterationsPerLevel), cascadeDone(false) {
+}
+
+void Multigrid::reset() {
+	this->levelOptimizer->reset();
+	this->cascadeDone = false;
+}
+
+bool Multigrid::step(PointArray &points, double totalLength, EnergyKernel &kernel, Util::ThreadPool &pool, StepReport &report) {
+	if (this->cascadeDone) {
+		return this->levelOptimizer->step(points, totalLength, kernel, pool, report);
+	}
+	this->cascadeDone = true;
+
+	// Число точек на уровнях, от самого грубого; последний уровень --
+	// исходный многоугольник, на нём релаксацию делают следующие шаги.
+	std::vector<std::size_t> sizes;
+	for (std::size_t size = points.size(); size >= this->coarsestSize; size /= 4) {
+		sizes.insert(sizes.begin(), size);
+	}
+	// Меньше 4 * coarsestSize точек: грубых уровней нет.
+	if (sizes.size() < 2) {
+		return this->levelOptimizer->step(points, totalLength, kernel, pool, report);
+	}
+
+	PointArray level;
+	std::size_t numberOfIterations = 0;
+	for (std::size_t index = 0; index < sizes.size() - 1; ++index) {
+		level = (index == 0 ? points : level).uniform(sizes[index]);
+		this->levelOptimizer->reset();
+		for (std::size_t iteration = 0; iteration < this->iterationsPerLevel; ++iteration) {
+			StepReport levelReport {0.0, 0.0, 0, 0.0, false, false};
+			if (!this->levelOptimizer->step(level, totalLength, kernel, pool, levelReport)) {
+				break;
+			}
+			++numberOfIterations;
+		}
+	}
+
+	level = level.uniform(points.size());
+	project(level, totalLength);
+	this->levelOptimizer->reset();
+
+	double shift = 0.0;
+	for (std::size_t i = 0; i < points.size(); ++i) {
+		shift = std::max(shift, fabs(level.x()[i] - points.x()[i]));
+		shift = std::max(shift, fabs(level.y()[i] - points.y()[i]));
+		shift = std::max(shift, fabs(level.z()[i] - points.z()[i]));
+	}
+	points.swap(level);
+
+	report.stepSize = shift * points.size() / totalLength;
+	report.energy = kernel.energy(points, pool);
+	report.hasEnergy = true;
+	report.numberOfTrials = numberOfIterations;
+	return true;
+}
+
+}
@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 1995-2021, Nikolay Pultsin <geometer@geometer.name>
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __KE_OPTIMIZER_H__
+#define __KE_OPTIMIZER_H__
+
+#include <memory>
+#include <vector>
+
+#include "EnergyKernel.h"
+#include "PointArray.h"
+#include "SobolevOperator.h"
+
+namespace KE::Util {
+
+class ThreadPool;
+
+}
+
+namespace KE::ThreeD {
+
+struct StepReport {
+	// maximal vertex shift relative to the average edge length;
+	// 0 if no step was accepted
+	double stepSize;
+	// Moebius energy after the step (energy-monitored optimizers only)
+	double energy;
+	// number of evaluated trial steps (energy-monitored optimizers only);
+	// for the multigrid cascade, the number of coarse level iterations
+	std::size_t numberOfTrials;
+	// maximum of absolute values of the energy gradient components
+	// before the step; not computed by the multigrid cascade
+	double gradientNorm;
+	// Whether energy and gradientNorm are set by the optimizer; the
+	// normalized energy may be zero or negative, so it is no sentinel.
+	bool hasEnergy;
+	bool hasGradientNorm;
+};
+
+// A smoothing strategy: turns the energy gradient into a step.
+// Knot::decreaseEnergy() calls step() once per iteration, with the points
+// already redistributed uniformly along the curve.
+class Optimizer {
+
+public:
+	enum class Method {
+		// fixed heuristic step
+		gradientDescent,
+		// gradient step with backtracking on the Moebius energy
+		lineSearch,
+		// limited-memory BFGS with backtracking on the Moebius energy
+		lbfgs,
+		// Sobolev-preconditioned gradient with backtracking on the Moebius energy
+		sobolev,
+		// L-BFGS on a coarse-to-fine sequence of resampled polygons
+		multigrid
+	};
+
+	static std::shared_ptr<Optimizer> create(Method method);
+
+public:
+	virtual ~Optimizer() {}
+
+	// Moves the points so that the energy decreases. The total length
+	// is kept and the center of mass is moved to the origin. Returns false
+	// and leaves the points unchanged if no step decreased the energy.
+	virtual bool step(PointArray &points, double totalLength, EnergyKernel &kernel, Util::ThreadPool &pool, StepReport &report) = 0;
+	// Forgets the state collected in the previous steps; called when the
+	// knot is changed not by the optimizer.
+	virtual void reset() {}
+
+protected:
+	// Restores the total length and moves the center of mass to the origin.
+	static void project(PointArray &points, double totalLength);
+	// Maximum of absolute values of the vector components.
+	static double maxComponent(const std::vector<Vector> &vectors);
+
+private:
+	PointArray candidate, resampled;
+
+protected:
+	// Tries points + coef * direction (projected), halving coef until
+	// the Moebius energy is less than the given one. Returns the accepted
+	// coef and replaces the points, or returns 0 if no trial succeeded.
+	double backtrack(PointArray &points, const std::vector<Vector> &direction, double coef, double energy, double totalLength, EnergyKernel &kernel, Util::ThreadPool &pool, StepReport &report);
+};
+
+class GradientDescent : public Optimizer {
+
+private:
+	std::vector<Vector> delta;
+
+public:
+	bool step(PointArray &points, double totalLength, EnergyKernel &kernel, Util::ThreadPool &pool, StepReport &report) override;
+};
+
+class LineSearch : public Optimizer {
+
+private:
+	// steps in average edge lengths
+	const double initialStepRatio;
+	const double maxStepRatio;
+	// step for the next iteration
+	double stepRatio;
+	std::vector<Vector> delta;
+
+public:
+	LineSearch(double initialStepRatio = 0.2, double maxStepRatio = 0.5);
+
+	bool step(PointArray &points, double totalLength, EnergyKernel &kernel, Util::ThreadPool &pool, StepReport &report) override;
+	void reset() override;
+
+	// Backtracking along the given direction; energy is the energy
+	// of the points. Used by step() with the plain gradient direction.
+	bool search(PointArray &points, const std::vector<Vector> &direction, double energy, double totalLength, EnergyKernel &kernel, Util::ThreadPool &pool, StepReport &report);
+};
+
+// Line search along the gradient preconditioned by the inverse of
+// a fractional Sobolev operator. Such a direction has no high-frequency
+// wiggles, so much longer steps are accepted. When it stops decreasing
+// the energy (close to a minimum) or is not a descent direction, plain
+// gradient steps are made for a while.
+class SobolevGradient : public Optimizer {
+
+private:
+	SobolevOperator sobolevOperator;
+	std::vector<Vector> delta, direction;
+	LineSearch sobolevSearch;
+	LineSearch gradientSearch;
+	// plain gradient iterations left before the next preconditioned one
+	std::size_t gradientIterations;
+
+public:
+	SobolevGradient(double order = 1.0);
+
+	bool step(PointArray &points, double totalLength, EnergyKernel &kernel, Util::ThreadPool &pool, StepReport &report) override;
+	void reset() override;
+
+private:
+	// Returns false if the direction is not a descent one.
+	bool computeDirection(const PointArray &points, Util::ThreadPool &pool);
+};
+
+class LBFGS : public Optimizer {
+
+private:
+	struct Correction {
+		// differences of the points and of the gradients
+		std::vector<Vector> s, y;
+		double rho;
+	};
+
+private:
+	const std::size_t historySize;
+	// the oldest correction first, plus a spare slot for the new
+	// correction until it passes the curvature check
+	std::vector<Correction> history;
+	std::size_t numberOfCorrections;
+	std::vector<double> alpha;
+
+	std::vector<Vector> delta, direction;
+	PointArray previousPoints;
+	std::vector<Vector> previousDelta;
+
+public:
+	LBFGS(std::size_t historySize = 8);
+
+	bool step(PointArray &points, double totalLength, EnergyKernel &kernel, Util::ThreadPool &pool, StepReport &report) override;
+	void reset() override;
+
+private:
+	void addCorrection(const PointArray &points);
+	void computeDirection();
+};
+
+// Coarse-to-fine smoothing. On the first step the knot is resampled
+// to a few hundred points and relaxed there; then the polygon is resampled
+// to 4 times more points and relaxed again, and so on up to the original
+// number of points. The cascade is made once (until reset()); all later
+// steps, and all steps for polygons with less than 4 * coarsestSize points,
+// are made on the original polygon.
+class Multigrid : public Optimizer {
+
+private:
+	const std::shared_ptr<Optimizer> levelOptimizer;
+	const std::size_t coarsestSize;
+	const std::size_t iterationsPerLevel;
+	bool cascadeDone;
+
+public:
+	Multigrid(Method levelMethod = Method::lbfgs, std::size_t coarsestSize = 256, std::size_t iterationsPerLevel = 200);
+
+	bool step(PointArray &points, double totalLength, EnergyKernel &kernel, Util::ThreadPool &pool, StepReport &report) override;
+	void reset() override;
+};
+
+}
+
+#endif /* __KE_OPTIMIZER_H__ */
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 1995-2021, Nikolay Pultsin <geometer@geometer.name>
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "PointArray.h"
+
+namespace KE::ThreeD {
+
+PointArray PointArray::uniform(std::size_t numberOfPoints) const {
+	PointArray newPoints;
+	this->uniform(numberOfPoints, newPoints);
+	return newPoints;
+}
+
+double PointArray::uniform(std::size_t numberOfPoints, PointArray &newPoints) const {
+	const std::size_t size = this->_size;
+	if (size < 2) {
+		// Пустой массив или одна точка: ломаной нет, все новые точки совпадают.
+		newPoints.resize(size == 0 ? 0 : numberOfPoints);
+		for (std::size_t i = 0; i < newPoints.size(); ++i) {
+			newPoints.set(i, (*this)[0]);
+		}
+		return 0.0;
+	}
+
+	// Длина ребра p_vp_{v+1}.
+	const auto edgeLength = [this, size](std::size_t v) {
+		return (*this)[v == size - 1 ? 0 : v + 1].distanceTo((*this)[v]);
+	};
+
+	double totalLength = 0.0;
+	for (std::size_t v = 0; v < size; ++v) {
+		totalLength += edgeLength(v);
+	}
+	const double newEdgeLength = totalLength / numberOfPoints;
+
+	newPoints.resize(numberOfPoints);
+
+	std::size_t v = 0;
+	double llen = edgeLength(0);
+	double rest = llen;
+
+	for (std::size_t i = 0; i < numberOfPoints; i++) {
+		const auto nextV = v == size - 1 ? 0 : v + 1;
+
+		const Vector delta((*this)[v], (*this)[nextV]);
+		Point pt((*this)[v]);
+		pt.move(delta, 1 - rest / llen);
+		newPoints.set(i, pt);
+
+		rest -= newEdgeLength;
+		while (rest < 0) {
+			v = v == size - 1 ? 0 : v + 1;
+			llen = edgeLength(v);
+			rest += llen;
+		}
+	}
+
+	return totalLength;
+}
+
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 1995-2021, Nikolay Pultsin <geometer@geometer.name>
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __KE_POINT_ARRAY_H__
+#define __KE_POINT_ARRAY_H__
+
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "primitives.h"
+
+namespace KE::Util {
+
+// Allocates memory aligned to a cache line, that is also enough for any SIMD register.
+template<typename T>
+struct AlignedAllocator {
+	typedef T value_type;
+	static constexpr std::size_t alignment = 64;
+
+	AlignedAllocator() {}
+	template<typename U> AlignedAllocator(const AlignedAllocator<U>&) {}
+
+	// Uses the aligned operator new, so that the memory is seen
+	// by a replaced global operator new (e.g., an allocation counter).
+	T *allocate(std::size_t size) {
+		return static_cast<T*>(::operator new(size * sizeof(T), std::align_val_t(alignment)));
+	}
+	void deallocate(T *memory, std::size_t) {
+		::operator delete(memory, std::align_val_t(alignment));
+	}
+
+	template<typename U> bool operator == (const AlignedAllocator<U>&) const { return true; }
+	template<typename U> bool operator != (const AlignedAllocator<U>&) const { return false; }
+};
+
+}
+
+namespace KE::ThreeD {
+
+// Structure-of-arrays point storage: x, y and z coordinates are kept
+// in separate aligned arrays, so loops over the points can be vectorized.
+// The arrays are padded with zeroes up to a multiple of simdWidth.
+class PointArray {
+
+public:
+	// Number of doubles in an AVX2 register.
+	static constexpr std::size_t simdWidth = 4;
+	typedef std::vector<double, Util::AlignedAllocator<double>> Coordinates;
+
+	static std::size_t paddedSize(std::size_t size) {
+		return (size + simdWidth - 1) / simdWidth * simdWidth;
+	}
+
+private:
+	std::size_t _size;
+	Coordinates _x, _y, _z;
+
+public:
+	PointArray() : _size(0) {}
+	PointArray(std::size_t size) : _size(0) { this->resize(size); }
+	PointArray(const std::vector<Point> &points) : _size(0) {
+		this->resize(points.size());
+		for (std::size_t i = 0; i < points.size(); ++i) {
+			this->set(i, points[i]);
+		}
+	}
+
+	std::size_t size() const { return this->_size; }
+	bool empty() const { return this->_size == 0; }
+	void resize(std::size_t size) {
+		this->_size = size;
+		this->_x.resize(paddedSize(size), 0.0);
+		this->_y.resize(paddedSize(size), 0.0);
+		this->_z.resize(paddedSize(size), 0.0);
+		for (std::size_t i = size; i < paddedSize(size); ++i) {
+			this->_x[i] = this->_y[i] = this->_z[i] = 0.0;
+		}
+	}
+
+	Point operator[](std::size_t index) const {
+		return Point(this->_x[index], this->_y[index], this->_z[index]);
+	}
+	void set(std::size_t index, const Point &point) {
+		this->_x[index] = point.x;
+		this->_y[index] = point.y;
+		this->_z[index] = point.z;
+	}
+	void move(std::size_t index, const Vector &v, double coef = 1.0) {
+		this->_x[index] += v.x * coef;
+		this->_y[index] += v.y * coef;
+		this->_z[index] += v.z * coef;
+	}
+
+	void moveAll(const Vector &v, double coef = 1.0) {
+		for (std::size_t i = 0; i < this->_size; ++i) {
+			this->_x[i] += v.x * coef;
+			this->_y[i] += v.y * coef;
+			this->_z[i] += v.z * coef;
+		}
+	}
+	void scale(double ratio) {
+		for (std::size_t i = 0; i < this->_size; ++i) {
+			this->_x[i] *= ratio;
+			this->_y[i] *= ratio;
+			this->_z[i] *= ratio;
+		}
+	}
+	Vector sum() const {
+		Vector sum(0.0, 0.0, 0.0);
+		for (std::size_t i = 0; i < this->_size; ++i) {
+			sum.x += this->_x[i];
+			sum.y += this->_y[i];
+			sum.z += this->_z[i];
+		}
+		return sum;
+	}
+	// Length of the closed polygon.
+	double closedLength() const {
+		double length = (*this)[this->_size - 1].distanceTo((*this)[0]);
+		for (std::size_t i = 0; i < this->_size - 1; ++i) {
+			length += (*this)[i].distanceTo((*this)[i + 1]);
+		}
+		return length;
+	}
+
+	// Points placed along the closed polygon at equal arc length
+	// distances, starting from the first point.
+	PointArray uniform(std::size_t numberOfPoints) const;
+	// The same, written to newPoints (that must not be this array);
+	// reuses its memory. Returns the polygon length.
+	double uniform(std::size_t numberOfPoints, PointArray &newPoints) const;
+
+	const double *x() const { return this->_x.data(); }
+	const double *y() const { return this->_y.data(); }
+	const double *z() const { return this->_z.data(); }
+	double *x() { return this->_x.data(); }
+	double *y() { return this->_y.data(); }
+	double *z() { return this->_z.data(); }
+
+	void swap(PointArray &other) {
+		std::swap(this->_size, other._size);
+		this->_x.swap(other._x);
+		this->_y.swap(other._y);
+		this->_z.swap(other._z);
+	}
+};
+
+}
+
+#endif /* __KE_POINT_ARRAY_H__ */
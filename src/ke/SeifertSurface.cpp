@@ -34,29 +34,54 @@ double det(const ThreeD::Point &pt0, const ThreeD::Point &pt1, const ThreeD::Poi
 }
 
 ThreeD::Vector SeifertSurface::gradient(const ThreeD::Point &point, const ThreeD::Knot::Snapshot &snapshot) {
-	ThreeD::Vector gradient(0.0, 0.0, 0.0);
-
-	for (std::size_t i = 0; i < snapshot.size(); i++) {
-		const ThreeD::Vector x(point, snapshot[i]);
-		const ThreeD::Vector r(snapshot[i], snapshot[snapshot.next(i)]);
-
-		const double xr = x.scalar_product(r);
-		const double x2 = x.square();
-		const double r2 = r.square();
-		const double tau = - xr / r2;
-		const double a2 = x2 + tau * xr;
-		const double coeff = ((tau - 1) / sqrt (x2 + r2 + xr + xr) - tau / sqrt(x2)) / a2;
+	const auto &points = snapshot.points();
+	const double *px = points.x(), *py = points.y(), *pz = points.z();
+	const std::size_t size = snapshot.size();
+
+	const auto term = [=](std::size_t i, std::size_t next, double &gx, double &gy, double &gz) {
+		const double x0 = px[i] - point.x;
+		const double x1 = py[i] - point.y;
+		const double x2 = pz[i] - point.z;
+		const double r0 = px[next] - px[i];
+		const double r1 = py[next] - py[i];
+		const double r2 = pz[next] - pz[i];
+
+		const double xr = x0 * r0 + x1 * r1 + x2 * r2;
+		const double xx = x0 * x0 + x1 * x1 + x2 * x2;
+		const double rr = r0 * r0 + r1 * r1 + r2 * r2;
+		const double tau = - xr / rr;
+		const double a2 = xx + tau * xr;
+		const double coeff = ((tau - 1) / sqrt(xx + rr + xr + xr) - tau / sqrt(xx)) / a2;
+
+		gx += (r1 * x2 - r2 * x1) * coeff;
+		gy += (r2 * x0 - r0 * x2) * coeff;
+		gz += (r0 * x1 - r1 * x0) * coeff;
+	};
+
+	constexpr std::size_t LANES = ThreeD::PointArray::simdWidth;
+	double gx[LANES] = {0.0}, gy[LANES] = {0.0}, gz[LANES] = {0.0};
+	std::size_t i = 0;
+	for (; i + LANES < size; i += LANES) {
+		for (std::size_t lane = 0; lane < LANES; ++lane) {
+			term(i + lane, i + lane + 1, gx[lane], gy[lane], gz[lane]);
+		}
+	}
+	for (std::size_t lane = 0; i < size; ++i, ++lane) {
+		term(i, snapshot.next(i), gx[lane], gy[lane], gz[lane]);
+	}
 
-		gradient.x += (r.y * x.z - r.z * x.y) * coeff;
-		gradient.y += (r.z * x.x - r.x * x.z) * coeff;
-		gradient.z += (r.x * x.y - r.y * x.x) * coeff;
+	ThreeD::Vector gradient(0.0, 0.0, 0.0);
+	for (std::size_t lane = 0; lane < LANES; ++lane) {
+		gradient.x += gx[lane];
+		gradient.y += gy[lane];
+		gradient.z += gz[lane];
 	}
 
 	gradient.normalize();
 	return gradient;
 }
 
-SeifertSurface::SeifertSurface(const ThreeD::KnotWrapper &base) : Surface(false, true), base(base) {
+SeifertSurface::SeifertSurface(const ThreeD::KnotWrapper &base) : Surface(base, false, true), base(base) {
 }
 
 bool SeifertSurface::isVisible() const {
@@ -71,7 +96,7 @@ const Color &SeifertSurface::backColor() const {
 	return this->base.seifertBackColor();
 }
 
-void SeifertSurface::addTriangles(seifert *s) const {
+void SeifertSurface::addTriangles(seifert *s, Mesh &mesh) const {
   // Это оч. убогая версия создания поверхности из графа.
   // Просто в каждой вершине для любых двух ``соседних соседей''
   // создается новый треугольник, треугольники НИКАК не связаны.
@@ -100,14 +125,14 @@ void SeifertSurface::addTriangles(seifert *s) const {
     sl->next->value->markUsed (s, sl->value);
 
     // Добавляем треугольник.
-    addpoint(s->point, s->gradient);
+    addpoint(mesh, s->point, s->gradient);
     // Правильно ориентируем треугольник.
     if (det(s->point, sl->value->point, sl->next->value->point, s->gradient) < 0) {
-      addpoint(sl->next->value->point, sl->next->value->gradient);
-      addpoint(sl->value->point, sl->value->gradient);
+      addpoint(mesh, sl->next->value->point, sl->next->value->gradient);
+      addpoint(mesh, sl->value->point, sl->value->gradient);
     } else {
-      addpoint(sl->value->point, sl->value->gradient);
-      addpoint(sl->next->value->point, sl->next->value->gradient);
+      addpoint(mesh, sl->value->point, sl->value->gradient);
+      addpoint(mesh, sl->next->value->point, sl->next->value->gradient);
     }
 
     // Следующий сосед.
@@ -117,30 +142,23 @@ void SeifertSurface::addTriangles(seifert *s) const {
   }
 }
 
-bool SeifertSurface::isObsolete() const {
-	return Surface::isObsolete() || !this->stored || this->stored->isObsolete();
-}
-
-void SeifertSurface::calculate() const {
-	const auto snapshot = this->base.snapshot();
-	this->stored = std::make_shared<ThreeD::Knot::Snapshot>(snapshot);
-
+void SeifertSurface::calculate(const ThreeD::Knot::Snapshot &snapshot, Mesh &mesh) const {
   // Создаем граф поверхности.
   seifert *s = new seifert(snapshot, this->base.seifertBasePoint());
   s->correction();
 
   // Создаем поверхность.
 
-  addTriangles(s);
+  addTriangles(s, mesh);
   seifert_ord *so = s->sord;
   while (so->prev) {
     so = so->prev;
-    addTriangles(so->value);
+    addTriangles(so->value, mesh);
   }
   so = s->sord;
   while (so->next) {
     so = so->next;
-    addTriangles(so->value);
+    addTriangles(so->value, mesh);
   }
 
   // Удаляем граф.
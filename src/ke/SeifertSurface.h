@@ -29,9 +29,6 @@ class SeifertSurface : public Surface {
 public:
 	static ThreeD::Vector gradient(const ThreeD::Point &point, const ThreeD::Knot::Snapshot &snapshot);
 
-private:
-	mutable std::shared_ptr<ThreeD::Knot::Snapshot> stored;
-
 private:
 	const ThreeD::KnotWrapper &base;
 
@@ -39,13 +36,12 @@ public:
 	SeifertSurface(const ThreeD::KnotWrapper &base);
 
 private:
-	void addTriangles(seifert *s) const;
-	void calculate() const override;
+	void addTriangles(seifert *s, Mesh &mesh) const;
+	void calculate(const ThreeD::Knot::Snapshot &snapshot, Mesh &mesh) const override;
 
 	const Color &frontColor() const override;
 	const Color &backColor() const override;
 
-	bool isObsolete() const override;
 	bool isVisible() const override;
 };
 
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 1995-2021, Nikolay Pultsin <geometer@geometer.name>
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "SmoothingSession.h"
+#include "ThreadPool.h"
+
+namespace KE::ThreeD {
+
+SmoothingSession::SmoothingSession() : loaded(false), _changed(false), _optimizer(std::make_shared<GradientDescent>()), _convergence(ConvergenceMonitor::Reason::none) {
+}
+
+void SmoothingSession::setNumberOfThreads(std::size_t numberOfThreads) {
+	if (numberOfThreads == 0) {
+		this->threadPool = nullptr;
+	} else if (!this->threadPool || this->threadPool->size() != numberOfThreads) {
+		this->threadPool = std::make_shared<Util::ThreadPool>(numberOfThreads);
+	}
+}
+
+void SmoothingSession::setGradientMethod(EnergyKernel::Method method, double openingAngle) {
+	this->_kernel.setMethod(method, openingAngle);
+}
+
+void SmoothingSession::setOptimizer(const std::shared_ptr<Optimizer> &optimizer) {
+	this->_optimizer = optimizer ? optimizer : std::make_shared<GradientDescent>();
+}
+
+void SmoothingSession::setConvergenceTolerances(const ConvergenceMonitor::Tolerances &tolerances) {
+	this->_monitor.setTolerances(tolerances);
+	this->_convergence = ConvergenceMonitor::Reason::none;
+}
+
+void SmoothingSession::reset() {
+	this->_optimizer->reset();
+	this->_monitor.reset();
+	this->_convergence = ConvergenceMonitor::Reason::none;
+	this->loaded = false;
+	this->_changed = false;
+}
+
+void SmoothingSession::load(const PointArray &points) {
+	if (!this->loaded) {
+		this->_points = points;
+		this->loaded = true;
+	}
+}
+
+bool SmoothingSession::step(StepReport &report) {
+	// Расставляем точки на кривой равномерно; длину кривой сохраняем,
+	// чтобы в конце восстановить ее.
+	const double totalLength = this->_points.uniform(this->_points.size(), this->back);
+
+	const bool moved = this->_optimizer->step(
+		this->back, totalLength, this->_kernel, this->threadPool ? *this->threadPool : Util::ThreadPool::shared(), report
+	);
+	if (moved) {
+		this->_points.swap(this->back);
+		this->_changed = true;
+	}
+	this->_convergence = this->_monitor.add(report);
+	return moved;
+}
+
+}
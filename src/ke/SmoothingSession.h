@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 1995-2021, Nikolay Pultsin <geometer@geometer.name>
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __KE_SMOOTHING_SESSION_H__
+#define __KE_SMOOTHING_SESSION_H__
+
+#include <memory>
+
+#include "ConvergenceMonitor.h"
+#include "EnergyKernel.h"
+#include "Optimizer.h"
+#include "PointArray.h"
+
+namespace KE::Util {
+
+class ThreadPool;
+
+}
+
+namespace KE::ThreeD {
+
+// Everything a smoothing iteration works with: the energy kernel,
+// the optimizer, the convergence monitor and the private copy of the points,
+// double-buffered.
+// All of them keep their memory between the iterations, so a step
+// on a polygon with an unchanged number of points allocates nothing.
+// The iterations are not seen outside until the owner copies points().
+class SmoothingSession {
+
+private:
+	PointArray _points, back;
+	// true if _points are a copy of the owner's points or a result of steps
+	bool loaded;
+	// true if _points were changed after the last markPublished()
+	bool _changed;
+	EnergyKernel _kernel;
+	std::shared_ptr<Optimizer> _optimizer;
+	std::shared_ptr<Util::ThreadPool> threadPool;
+	ConvergenceMonitor _monitor;
+	ConvergenceMonitor::Reason _convergence;
+
+public:
+	SmoothingSession();
+
+	// 0 means the shared pool with a thread per hardware core.
+	void setNumberOfThreads(std::size_t numberOfThreads);
+	void setGradientMethod(EnergyKernel::Method method, double openingAngle);
+	// nullptr means the default (gradient descent) optimizer.
+	void setOptimizer(const std::shared_ptr<Optimizer> &optimizer);
+	void setConvergenceTolerances(const ConvergenceMonitor::Tolerances &tolerances);
+	// Called when the owner's points are changed not by the session;
+	// the next load() copies them again, and the convergence monitor
+	// starts from scratch.
+	void reset();
+
+	// Copies the points if the session has no own copy yet.
+	void load(const PointArray &points);
+	// Redistributes the points uniformly and makes an optimizer step.
+	bool step(StepReport &report);
+
+	const PointArray &points() const { return this->_points; }
+	// The monitor's verdict after the last step.
+	ConvergenceMonitor::Reason convergence() const { return this->_convergence; }
+	const ConvergenceMonitor &monitor() const { return this->_monitor; }
+	bool changed() const { return this->_changed; }
+	void markPublished() { this->_changed = false; }
+};
+
+}
+
+#endif /* __KE_SMOOTHING_SESSION_H__ */
@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 1995-2021, Nikolay Pultsin <geometer@geometer.name>
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "SobolevOperator.h"
+#include "ThreadPool.h"
+
+namespace KE::ThreeD {
+
+namespace {
+
+const std::size_t CHUNK_SIZE = 64;
+
+double dot(const std::vector<Vector> &v0, const std::vector<Vector> &v1) {
+	double sum = 0.0;
+	for (std::size_t i = 0; i < v0.size(); ++i) {
+		sum += v0[i].scalar_product(v1[i]);
+	}
+	return sum;
+}
+
+}
+
+SobolevOperator::SobolevOperator(double order, double openingAngle) : order(order), openingAngle(openingAngle), size(0) {
+}
+
+void SobolevOperator::build(const PointArray &points, Util::ThreadPool &pool) {
+	this->size = points.size();
+	const std::size_t size = this->size;
+
+	// Вес вершины -- половина суммы длин смежных рёбер.
+	this->weights.assign(PointArray::paddedSize(size), 0.0);
+	double length = 0.0;
+	for (std::size_t i = 0; i < size; ++i) {
+		const std::size_t next = i == size - 1 ? 0 : i + 1;
+		const double edge = points[i].distanceTo(points[next]);
+		this->weights[i] += edge / 2;
+		this->weights[next] += edge / 2;
+		length += edge;
+	}
+	this->octree.build(points, this->weights.data());
+
+	const double exponent = (1 + 2 * this->order) / 2;
+	const double mass = pow(length, - 2 * this->order);
+	this->diagonal.resize(size);
+	this->chunks.resize(Util::ThreadPool::numberOfChunks(size, CHUNK_SIZE));
+	pool.run(this->chunks.size(), [&](std::size_t index) {
+		Chunk &chunk = this->chunks[index];
+		chunk.nearEnd.clear();
+		chunk.farEnd.clear();
+		chunk.nearIndex.clear();
+		chunk.farNode.clear();
+		chunk.nearCoef.clear();
+		chunk.farCoef.clear();
+
+		const std::size_t begin = index * CHUNK_SIZE;
+		const std::size_t end = std::min(begin + CHUNK_SIZE, size);
+		const auto &nodes = this->octree.nodes();
+		for (std::size_t i = begin; i < end; ++i) {
+			const Point pi = points[i];
+			const double wi = this->weights[i];
+			double sum = mass * wi;
+			this->octree.traverse(pi, this->openingAngle, 0.0, [&](const Octree::Node &node) {
+				const double coef = wi * node.weight / pow(Vector(pi, node.center).square(), exponent);
+				chunk.farNode.push_back(&node - nodes.data());
+				chunk.farCoef.push_back(coef);
+				sum += coef;
+			}, [&](std::size_t j) {
+				if (j != i) {
+					const double coef = wi * this->weights[j] / pow(Vector(pi, points[j]).square(), exponent);
+					chunk.nearIndex.push_back(j);
+					chunk.nearCoef.push_back(coef);
+					sum += coef;
+				}
+			});
+			chunk.nearEnd.push_back(chunk.nearIndex.size());
+			chunk.farEnd.push_back(chunk.farNode.size());
+			this->diagonal[i] = sum;
+		}
+	});
+}
+
+void SobolevOperator::apply(const std::vector<Vector> &u, std::vector<Vector> &result, Util::ThreadPool &pool) {
+	// Средние значения u по узлам дерева с весами w_j; потомки
+	// в массиве узлов всегда идут после родителя.
+	const auto &nodes = this->octree.nodes();
+	const auto &indices = this->octree.indices();
+	this->nodeAverages.assign(nodes.size(), Vector(0.0, 0.0, 0.0));
+	for (std::size_t n = nodes.size(); n-- > 0; ) {
+		const Octree::Node &node = nodes[n];
+		Vector &average = this->nodeAverages[n];
+		if (node.isLeaf) {
+			for (std::size_t k = node.begin; k < node.end; ++k) {
+				average.add(u[indices[k]], this->weights[indices[k]]);
+			}
+		} else {
+			for (std::size_t child : node.children) {
+				if (child) {
+					average.add(this->nodeAverages[child], nodes[child].weight);
+				}
+			}
+		}
+	}
+	for (std::size_t n = 0; n < nodes.size(); ++n) {
+		const double weight = nodes[n].weight;
+		this->nodeAverages[n].x /= weight;
+		this->nodeAverages[n].y /= weight;
+		this->nodeAverages[n].z /= weight;
+	}
+
+	result.resize(this->size, Vector(0.0, 0.0, 0.0));
+	pool.run(this->chunks.size(), [&](std::size_t index) {
+		const Chunk &chunk = this->chunks[index];
+		const std::size_t begin = index * CHUNK_SIZE;
+		std::size_t near = 0, far = 0;
+		for (std::size_t k = 0; k < chunk.nearEnd.size(); ++k) {
+			const std::size_t i = begin + k;
+			Vector value(u[i].x * this->diagonal[i], u[i].y * this->diagonal[i], u[i].z * this->diagonal[i]);
+			for (; near < chunk.nearEnd[k]; ++near) {
+				value.add(u[chunk.nearIndex[near]], - chunk.nearCoef[near]);
+			}
+			for (; far < chunk.farEnd[k]; ++far) {
+				value.add(this->nodeAverages[chunk.farNode[far]], - chunk.farCoef[far]);
+			}
+			result[i] = value;
+		}
+	});
+}
+
+// Стабилизированный метод бисопряжённых градиентов с предобуславливанием
+// справа: x = M^{-1} y, где M -- диагональ A. Вектор тени r^ = b.
+std::size_t SobolevOperator::solve(const std::vector<Vector> &b, std::vector<Vector> &x, Util::ThreadPool &pool, double tolerance, std::size_t maxIterations) {
+	const std::size_t size = this->size;
+	const auto precondition = [this, size](const std::vector<Vector> &v, std::vector<Vector> &result) {
+		for (std::size_t i = 0; i < size; ++i) {
+			const double coef = 1.0 / this->diagonal[i];
+			result[i] = Vector(v[i].x * coef, v[i].y * coef, v[i].z * coef);
+		}
+	};
+
+	x.assign(size, Vector(0.0, 0.0, 0.0));
+	this->residual = b;
+	this->shadow = b;
+	this->direction.assign(size, Vector(0.0, 0.0, 0.0));
+	this->product.assign(size, Vector(0.0, 0.0, 0.0));
+	this->preconditioned.resize(size, Vector(0.0, 0.0, 0.0));
+	this->intermediate.resize(size, Vector(0.0, 0.0, 0.0));
+	this->preconditionedIntermediate.resize(size, Vector(0.0, 0.0, 0.0));
+
+	const double limit = tolerance * tolerance * dot(b, b);
+	double rho = 1.0, alpha = 1.0, omega = 1.0;
+	std::size_t iteration = 0;
+	while (iteration < maxIterations && dot(this->residual, this->residual) > limit) {
+		++iteration;
+		const double nextRho = dot(this->shadow, this->residual);
+		if (nextRho == 0.0 || omega == 0.0) {
+			break;
+		}
+		const double beta = nextRho / rho * alpha / omega;
+		rho = nextRho;
+		for (std::size_t i = 0; i < size; ++i) {
+			Vector &p = this->direction[i];
+			p.add(this->product[i], - omega);
+			p = Vector::linear(this->residual[i], 1.0, p, beta);
+		}
+		precondition(this->direction, this->preconditioned);
+		this->apply(this->preconditioned, this->product, pool);
+
+		const double denominator = dot(this->shadow, this->product);
+		if (denominator == 0.0) {
+			break;
+		}
+		alpha = rho / denominator;
+		for (std::size_t i = 0; i < size; ++i) {
+			x[i].add(this->preconditioned[i], alpha);
+			this->intermediate[i] = Vector::linear(this->residual[i], 1.0, this->product[i], - alpha);
+		}
+		if (dot(this->intermediate, this->intermediate) <= limit) {
+			break;
+		}
+
+		precondition(this->intermediate, this->preconditionedIntermediate);
+		this->apply(this->preconditionedIntermediate, this->intermediateProduct, pool);
+		const double tt = dot(this->intermediateProduct, this->intermediateProduct);
+		omega = tt > 0.0 ? dot(this->intermediateProduct, this->intermediate) / tt : 0.0;
+		for (std::size_t i = 0; i < size; ++i) {
+			x[i].add(this->preconditionedIntermediate[i], omega);
+			this->residual[i] = Vector::linear(this->intermediate[i], 1.0, this->intermediateProduct[i], - omega);
+		}
+	}
+	return iteration;
+}
+
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 1995-2021, Nikolay Pultsin <geometer@geometer.name>
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __KE_SOBOLEV_OPERATOR_H__
+#define __KE_SOBOLEV_OPERATOR_H__
+
+#include <vector>
+
+#include "Octree.h"
+#include "PointArray.h"
+
+namespace KE::Util {
+
+class ThreadPool;
+
+}
+
+namespace KE::ThreeD {
+
+// Discrete fractional Sobolev (H^s) operator on a closed polygon:
+//   (A u)_i = m w_i u_i + sum_j w_i w_j (u_i - u_j) / |p_i - p_j|^(1 + 2s),
+// where w_i is the vertex dual length and m is a small mass term that makes
+// A positive definite. Far vertex groups are taken from an octree, as in
+// the far-field gradient, so an application costs O(n log n). The octree
+// approximation is not symmetric (vertex i sees a group containing j, while
+// j may see i exactly or through another group), so the system is solved
+// by BiCGSTAB rather than by conjugate gradients.
+class SobolevOperator {
+
+private:
+	struct Chunk {
+		// per-vertex ends of the near and far lists
+		std::vector<std::size_t> nearEnd, farEnd;
+		std::vector<std::size_t> nearIndex, farNode;
+		std::vector<double> nearCoef, farCoef;
+	};
+
+private:
+	const double order;
+	const double openingAngle;
+
+	std::size_t size;
+	PointArray::Coordinates weights;
+	std::vector<double> diagonal;
+	Octree octree;
+	std::vector<Chunk> chunks;
+	// weighted node averages of the argument, see apply()
+	std::vector<Vector> nodeAverages;
+	// BiCGSTAB vectors
+	std::vector<Vector> residual, shadow, direction, preconditioned, product, intermediate, preconditionedIntermediate, intermediateProduct;
+
+public:
+	SobolevOperator(double order = 1.0, double openingAngle = 0.5);
+
+	void build(const PointArray &points, Util::ThreadPool &pool);
+	void apply(const std::vector<Vector> &u, std::vector<Vector> &result, Util::ThreadPool &pool);
+	// Solves A x = b by BiCGSTAB with Jacobi preconditioner; returns the
+	// number of iterations (each costs two applications of A). On a breakdown
+	// or after maxIterations x is the last iterate.
+	std::size_t solve(const std::vector<Vector> &b, std::vector<Vector> &x, Util::ThreadPool &pool, double tolerance = 1e-2, std::size_t maxIterations = 64);
+};
+
+}
+
+#endif /* __KE_SOBOLEV_OPERATOR_H__ */
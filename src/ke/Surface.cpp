@@ -14,34 +14,37 @@
  * limitations under the License.
  */
 
+#include "KnotWrapper.h"
 #include "Surface.h"
 
 namespace KE::GL {
 
-Surface::Surface(bool stripped, bool showBackSide) : stripped(stripped), showBackSide(showBackSide) {}
+Surface::Surface(const ThreeD::KnotWrapper &knot, bool stripped, bool showBackSide) : stripped(stripped), showBackSide(showBackSide), knot(knot), mesh([this](const ThreeD::Knot::Snapshot &snapshot) {
+	auto mesh = std::make_shared<Mesh>();
+	if (snapshot.size() > 0) {
+		this->calculate(snapshot, *mesh);
+	}
+	return std::shared_ptr<const Mesh>(mesh);
+}) {
+}
 
 Surface::~Surface() {
 }
 
 bool Surface::isObsolete() const {
-	return this->_points.empty();
+	return !this->prepared || this->mesh.storedValue(this->knot.snapshot()) != this->prepared;
 }
 
 void Surface::destroy() {
-	this->_points.clear();
+	this->mesh.invalidate();
 }
 
-void Surface::addpoint(const ThreeD::Point &vertex, const ThreeD::Vector &normal) const {
-	this->_points.push_back(SurfacePoint(vertex.x, vertex.y, vertex.z, normal.x, normal.y, normal.z));
+void Surface::addpoint(Mesh &mesh, const ThreeD::Point &vertex, const ThreeD::Vector &normal) {
+	mesh.push_back(SurfacePoint(vertex.x, vertex.y, vertex.z, normal.x, normal.y, normal.z));
 }
 
 void Surface::prepare() const {
-	if (this->isObsolete()) {
-		this->_points.clear();
-	}
-	if (this->_points.empty()) {
-		this->calculate();
-	}
+	this->prepared = this->mesh.value(this->knot.snapshot());
 }
 
 }
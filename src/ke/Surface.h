@@ -20,7 +20,13 @@
 #include <vector>
 
 #include "Color.h"
-#include "primitives.h"
+#include "DerivedData.h"
+
+namespace KE::ThreeD {
+
+class KnotWrapper;
+
+}
 
 namespace KE::GL {
 
@@ -30,7 +36,7 @@ public:
 	const bool stripped;
 	const bool showBackSide;
 
-private:
+public:
 	struct SurfacePoint {
 		float vertex[3];
 		float normal[3];
@@ -44,23 +50,31 @@ private:
 			normal[2] = n2;
 		}
 	};
+	typedef std::vector<SurfacePoint> Mesh;
 
-	mutable std::vector<SurfacePoint> _points;
+private:
+	const ThreeD::KnotWrapper &knot;
+	// The mesh for the current knot generation and surface options.
+	ThreeD::DerivedData<Mesh> mesh;
+	// The mesh returned by the last prepare() call.
+	mutable std::shared_ptr<const Mesh> prepared;
 
 protected:
-	virtual void calculate() const = 0;
-	void addpoint(const ThreeD::Point &vertex, const ThreeD::Vector &normal) const;
+	virtual void calculate(const ThreeD::Knot::Snapshot &snapshot, Mesh &mesh) const = 0;
+	static void addpoint(Mesh &mesh, const ThreeD::Point &vertex, const ThreeD::Vector &normal);
 
 public:
-	Surface(bool stripped, bool showBackSide);
+	Surface(const ThreeD::KnotWrapper &knot, bool stripped, bool showBackSide);
 	virtual ~Surface();
 
 	void prepare() const;
 
-	const std::vector<SurfacePoint> &points() const { return this->_points; }
+	const Mesh &points() const { return *this->prepared; }
 
 	virtual bool isVisible() const = 0;
-	virtual bool isObsolete() const;
+	// True if the prepared mesh is not the mesh for the current knot and options.
+	bool isObsolete() const;
+	// Must be called when an option used by calculate() changes.
 	void destroy();
 
 	virtual const Color &frontColor() const = 0;
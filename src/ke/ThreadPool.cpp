@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 1995-2021, Nikolay Pultsin <geometer@geometer.name>
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+
+#include "ThreadPool.h"
+
+namespace KE::Util {
+
+ThreadPool &ThreadPool::shared() {
+	static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+	return pool;
+}
+
+ThreadPool::ThreadPool(std::size_t size) : stopping(false) {
+	for (std::size_t i = 1; i < size; ++i) {
+		this->workers.push_back(std::thread([this] { this->workerLoop(); }));
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> guard(this->mutex);
+		this->stopping = true;
+	}
+	this->jobAdded.notify_all();
+	for (auto &worker : this->workers) {
+		worker.join();
+	}
+}
+
+bool ThreadPool::runNextTask(std::unique_lock<std::mutex> &lock, Job &job) {
+	if (job.nextTask == job.numberOfTasks) {
+		return false;
+	}
+	const std::size_t index = job.nextTask++;
+	if (job.nextTask == job.numberOfTasks) {
+		this->jobs.erase(std::find(this->jobs.begin(), this->jobs.end(), &job));
+	}
+	lock.unlock();
+	job.invoke(job.task, index);
+	lock.lock();
+	job.finishedTasks += 1;
+	if (job.finishedTasks == job.numberOfTasks) {
+		this->jobFinished.notify_all();
+	}
+	return true;
+}
+
+void ThreadPool::run(std::size_t numberOfTasks, const void *task, Invoker invoke) {
+	if (numberOfTasks == 0) {
+		return;
+	}
+	if (this->workers.empty() || numberOfTasks == 1) {
+		for (std::size_t index = 0; index < numberOfTasks; ++index) {
+			invoke(task, index);
+		}
+		return;
+	}
+
+	Job job(task, invoke, numberOfTasks);
+	std::unique_lock<std::mutex> lock(this->mutex);
+	this->jobs.push_back(&job);
+	this->jobAdded.notify_all();
+	while (this->runNextTask(lock, job)) {
+	}
+	// Tasks taken by the workers may still be running.
+	this->jobFinished.wait(lock, [&job] { return job.finishedTasks == job.numberOfTasks; });
+}
+
+void ThreadPool::workerLoop() {
+	std::unique_lock<std::mutex> lock(this->mutex);
+	while (true) {
+		this->jobAdded.wait(lock, [this] { return this->stopping || !this->jobs.empty(); });
+		if (this->stopping) {
+			break;
+		}
+		this->runNextTask(lock, *this->jobs.front());
+	}
+}
+
+}
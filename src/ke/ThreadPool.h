@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 1995-2021, Nikolay Pultsin <geometer@geometer.name>
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __KE_THREAD_POOL_H__
+#define __KE_THREAD_POOL_H__
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace KE::Util {
+
+class ThreadPool {
+
+public:
+	static ThreadPool &shared();
+
+	// Splits [0, size) into consecutive chunks of the given length.
+	// The split does not depend on the number of threads, so the per-chunk
+	// results reduced in chunk order are the same for any pool size.
+	static std::size_t numberOfChunks(std::size_t size, std::size_t chunkSize) {
+		return (size + chunkSize - 1) / chunkSize;
+	}
+
+private:
+	// The task is kept as a plain pointer to the caller's callable,
+	// so that run() does not allocate.
+	typedef void (*Invoker)(const void *task, std::size_t index);
+
+	struct Job {
+		const void *task;
+		const Invoker invoke;
+		const std::size_t numberOfTasks;
+		std::size_t nextTask;
+		std::size_t finishedTasks;
+
+		Job(const void *task, Invoker invoke, std::size_t numberOfTasks) : task(task), invoke(invoke), numberOfTasks(numberOfTasks), nextTask(0), finishedTasks(0) {}
+	};
+
+private:
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable jobAdded;
+	std::condition_variable jobFinished;
+	std::vector<Job*> jobs;
+	bool stopping;
+
+public:
+	// The calling thread takes part in every run(), so a pool of size N
+	// starts N - 1 worker threads; size 1 means "no extra threads".
+	ThreadPool(std::size_t size);
+	~ThreadPool();
+
+	std::size_t size() const { return this->workers.size() + 1; }
+
+	// Calls task(index) for every index in [0, numberOfTasks) and returns
+	// when all the calls are finished. Tasks must not throw.
+	template<typename Task>
+	void run(std::size_t numberOfTasks, const Task &task) {
+		this->run(numberOfTasks, &task, [](const void *task, std::size_t index) {
+			(*static_cast<const Task*>(task))(index);
+		});
+	}
+
+private:
+	void run(std::size_t numberOfTasks, const void *task, Invoker invoke);
+	void workerLoop();
+	bool runNextTask(std::unique_lock<std::mutex> &lock, Job &job);
+
+private:
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator = (const ThreadPool&) = delete;
+};
+
+}
+
+#endif /* __KE_THREAD_POOL_H__ */
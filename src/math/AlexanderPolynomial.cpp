@@ -88,13 +88,15 @@ struct Face {
 };
 
 std::vector<Face> collectFaces(const Diagram &diagram) {
-	const auto edges = diagram.edges();
-	auto edge2Crossings = diagram.allCrossings();
+	const auto &edges = diagram.edges();
+	const auto &sequence = diagram.crossingSequence();
 
 	std::vector<CrossingEx> all;
-	for (const auto &edge : edges) {
-		for (const auto &cro : edge2Crossings[edge]) {
-			all.push_back(CrossingEx(cro, cro.up == edge));
+	all.reserve(sequence.crossings.size());
+	for (std::size_t index = 0; index < edges.size(); ++index) {
+		for (std::size_t i = sequence.offsets[index]; i < sequence.offsets[index + 1]; ++i) {
+			const auto &cro = sequence.crossings[i];
+			all.push_back(CrossingEx(cro, cro.up == edges[index]));
 		}
 	}
 	std::map<CrossingEx,CrossingEx> next;
@@ -30,8 +30,8 @@ std::list<int> DTCode::value(const Diagram &diagram) const {
 		return {};
 	}
 
-	const auto edges = diagram.edges();
-	auto edge2Crossings = diagram.allCrossings();
+	const auto &edges = diagram.edges();
+	const auto &sequence = diagram.crossingSequence();
 
 	struct CrossingEx {
 		const Diagram::Crossing cro;
@@ -41,9 +41,10 @@ std::list<int> DTCode::value(const Diagram &diagram) const {
 	};
 
 	std::list<CrossingEx> all;
-	for (const auto &edge : edges) {
-		for (const auto &cro : edge2Crossings[edge]) {
-			all.push_back(CrossingEx(cro, cro.up == edge));
+	for (std::size_t index = 0; index < edges.size(); ++index) {
+		for (std::size_t i = sequence.offsets[index]; i < sequence.offsets[index + 1]; ++i) {
+			const auto &cro = sequence.crossings[i];
+			all.push_back(CrossingEx(cro, cro.up == edges[index]));
 		}
 	}
 
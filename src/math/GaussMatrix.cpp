@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 1995-2021, Nikolay Pultsin <geometer@geometer.name>
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <algorithm>
+#include <cmath>
+
+#include "GaussMatrix.h"
+#include "../ke/ThreadPool.h"
+
+namespace KE::ThreeD::Math {
+
+namespace {
+
+// rows and columns per tile of the dense matrix
+const std::size_t DENSE_TILE_SIZE = 64;
+// rows per chunk of the segment integrals
+const std::size_t SEGMENT_CHUNK_SIZE = 16;
+const std::size_t LANES = PointArray::simdWidth;
+// pairs of edges with relative volume of the tetrahedron below that are coplanar
+const double COPLANAR_EPSILON = 1e-12;
+
+// Единичная нормаль [a, b] / |[a, b]|; для вырожденной пары -- ноль.
+inline void normal(double ax, double ay, double az, double bx, double by, double bz, double &nx, double &ny, double &nz) {
+	nx = ay * bz - az * by;
+	ny = az * bx - ax * bz;
+	nz = ax * by - ay * bx;
+	const double len = sqrt(nx * nx + ny * ny + nz * nz);
+	const double inverse = len > 0.0 ? 1.0 / len : 0.0;
+	nx *= inverse;
+	ny *= inverse;
+	nz *= inverse;
+}
+
+inline double arcsin(double n0x, double n0y, double n0z, double n1x, double n1y, double n1z) {
+	return asin(std::max(-1.0, std::min(1.0, n0x * n1x + n0y * n1y + n0z * n1z)));
+}
+
+// Телесный угол (со знаком), под которым ребро a0a1 видно из ребра b0b1
+// (Klenin, Langowski, 2000): сумма углов сферического четырёхугольника
+// из нормалей к граням тетраэдра a0a1b0b1.
+inline double solidAngle(const PointArray &starts, const PointArray &ends, std::size_t i, std::size_t j) {
+	const double *sx = starts.x(), *sy = starts.y(), *sz = starts.z();
+	const double *ex = ends.x(), *ey = ends.y(), *ez = ends.z();
+	const double r13x = sx[j] - sx[i], r13y = sy[j] - sy[i], r13z = sz[j] - sz[i];
+	const double r14x = ex[j] - sx[i], r14y = ey[j] - sy[i], r14z = ez[j] - sz[i];
+	const double r23x = sx[j] - ex[i], r23y = sy[j] - ey[i], r23z = sz[j] - ez[i];
+	const double r24x = ex[j] - ex[i], r24y = ey[j] - ey[i], r24z = ez[j] - ez[i];
+	double n1x, n1y, n1z, n2x, n2y, n2z, n3x, n3y, n3z, n4x, n4y, n4z;
+	normal(r13x, r13y, r13z, r14x, r14y, r14z, n1x, n1y, n1z);
+	normal(r14x, r14y, r14z, r24x, r24y, r24z, n2x, n2y, n2z);
+	normal(r24x, r24y, r24z, r23x, r23y, r23z, n3x, n3y, n3z);
+	normal(r23x, r23y, r23z, r13x, r13y, r13z, n4x, n4y, n4z);
+	const double omega =
+		arcsin(n1x, n1y, n1z, n2x, n2y, n2z) +
+		arcsin(n2x, n2y, n2z, n3x, n3y, n3z) +
+		arcsin(n3x, n3y, n3z, n4x, n4y, n4z) +
+		arcsin(n4x, n4y, n4z, n1x, n1y, n1z);
+	// Знак -- знак ([b0b1, a0a1], r13). Если рёбра лежат в одной плоскости
+	// (с точностью до округления), нормали вырождены, а телесный угол равен нулю.
+	const double ax = ex[i] - sx[i], ay = ey[i] - sy[i], az = ez[i] - sz[i];
+	const double bx = ex[j] - sx[j], by = ey[j] - sy[j], bz = ez[j] - sz[j];
+	const double triple = (by * az - bz * ay) * r13x + (bz * ax - bx * az) * r13y + (bx * ay - by * ax) * r13z;
+	const double scale =
+		(ax * ax + ay * ay + az * az) * (bx * bx + by * by + bz * bz) * (r13x * r13x + r13y * r13y + r13z * r13z);
+	if (triple * triple <= COPLANAR_EPSILON * COPLANAR_EPSILON * scale) {
+		return 0.0;
+	}
+	return triple > 0.0 ? omega : - omega;
+}
+
+}
+
+GaussKernel::GaussKernel(const Knot::Snapshot &snapshot) : middles(snapshot.size()), tangents(snapshot.size()) {
+	const auto &points = snapshot.points();
+	for (std::size_t i = 0; i < snapshot.size(); ++i) {
+		const std::size_t next = snapshot.next(i);
+		this->middles.set(i, Point(points.x()[i] + points.x()[next], points.y()[i] + points.y()[next], points.z()[i] + points.z()[next]));
+		this->tangents.set(i, Point(points.x()[next] - points.x()[i], points.y()[next] - points.y()[i], points.z()[next] - points.z()[i]));
+	}
+}
+
+void GaussKernel::row(std::size_t i, double *row) const {
+	for (std::size_t j = 0; j < i; ++j) {
+		row[j] = this->product(i, j);
+	}
+	row[i] = 0.0;
+	for (std::size_t j = i + 1; j < this->size(); ++j) {
+		row[j] = this->product(j, i);
+	}
+}
+
+std::shared_ptr<const GaussMatrix> GaussMatrix::cached(const Knot::Snapshot &snapshot, ComputationToken &token) {
+	static const std::size_t key = Knot::Snapshot::newKey();
+	return std::static_pointer_cast<const GaussMatrix>(snapshot.cachedValue(key, 0, [&snapshot, &token]() -> std::shared_ptr<const void> {
+		auto matrix = std::make_shared<const GaussMatrix>(snapshot, token);
+		return token.isCancelled() ? nullptr : matrix;
+	}));
+}
+
+GaussMatrix::GaussMatrix(const Knot::Snapshot &snapshot, const ComputationToken &token) : _size(snapshot.size()), values(snapshot.size() * snapshot.size(), 0.0) {
+	const std::size_t size = this->_size;
+	const GaussKernel kernel(snapshot);
+
+	// Нижний треугольник считается по полосам из DENSE_TILE_SIZE строк, полосы
+	// делятся между потоками; внутри полосы -- по квадратным блокам, чтобы
+	// столбцы блока оставались в кэше. Верхний треугольник -- отражение.
+	double *values = this->values.data();
+	Util::ThreadPool::shared().run(Util::ThreadPool::numberOfChunks(size, DENSE_TILE_SIZE), [&kernel, &token, values, size](std::size_t tile) {
+		if (token.isCancelled()) {
+			return;
+		}
+		const std::size_t begin = tile * DENSE_TILE_SIZE;
+		const std::size_t end = std::min(begin + DENSE_TILE_SIZE, size);
+		for (std::size_t columns = 0; columns < end; columns += DENSE_TILE_SIZE) {
+			for (std::size_t i = begin; i < end; ++i) {
+				double *row = values + i * size;
+				for (std::size_t j = columns; j < std::min(columns + DENSE_TILE_SIZE, i); ++j) {
+					row[j] = kernel(i, j);
+					values[j * size + i] = row[j];
+				}
+			}
+		}
+	});
+}
+
+GaussRows::GaussRows(const Knot::Snapshot &snapshot, ComputationToken &token) : tileBegin(0), tileEnd(0) {
+	if (snapshot.size() <= GaussMatrix::MAX_SIZE) {
+		this->matrix = GaussMatrix::cached(snapshot, token);
+	} else {
+		this->kernel = std::make_unique<GaussKernel>(snapshot);
+		this->tile.resize(TILE_SIZE * snapshot.size());
+	}
+}
+
+const double *GaussRows::row(std::size_t i) {
+	if (this->matrix) {
+		return this->matrix->row(i);
+	}
+
+	const std::size_t size = this->kernel->size();
+	if (i < this->tileBegin || i >= this->tileEnd) {
+		this->tileBegin = i / TILE_SIZE * TILE_SIZE;
+		this->tileEnd = std::min(this->tileBegin + TILE_SIZE, size);
+		Util::ThreadPool::shared().run(this->tileEnd - this->tileBegin, [this, size](std::size_t index) {
+			this->kernel->row(this->tileBegin + index, this->tile.data() + index * size);
+		});
+	}
+	return this->tile.data() + (i - this->tileBegin) * size;
+}
+
+std::shared_ptr<const SegmentGaussIntegrals> SegmentGaussIntegrals::cached(const Knot::Snapshot &snapshot, ComputationToken &token) {
+	static const std::size_t key = Knot::Snapshot::newKey();
+	return std::static_pointer_cast<const SegmentGaussIntegrals>(snapshot.cachedValue(key, 0, [&snapshot, &token]() -> std::shared_ptr<const void> {
+		auto integrals = std::make_shared<const SegmentGaussIntegrals>(snapshot, token);
+		return token.isCancelled() ? nullptr : integrals;
+	}));
+}
+
+SegmentGaussIntegrals::SegmentGaussIntegrals(const Knot::Snapshot &snapshot, ComputationToken &token) : writhe(0.0), averageCrossingNumber(0.0) {
+	const std::size_t size = snapshot.size();
+	const auto &starts = snapshot.points();
+	PointArray ends(size);
+	for (std::size_t i = 0; i < size; ++i) {
+		ends.set(i, starts[snapshot.next(i)]);
+	}
+
+	// Пары несмежных рёбер i < j; строки делятся на куски между потоками,
+	// суммы кусков складываются по порядку.
+	const std::size_t numberOfChunks = Util::ThreadPool::numberOfChunks(size, SEGMENT_CHUNK_SIZE);
+	std::vector<double> signedSums(numberOfChunks, 0.0), absoluteSums(numberOfChunks, 0.0);
+	token.start(numberOfChunks);
+	Util::ThreadPool::shared().run(numberOfChunks, [&](std::size_t chunk) {
+		if (token.isCancelled()) {
+			return;
+		}
+		double sums[LANES] = {0.0}, absSums[LANES] = {0.0};
+		for (std::size_t i = chunk * SEGMENT_CHUNK_SIZE; i < std::min((chunk + 1) * SEGMENT_CHUNK_SIZE, size); ++i) {
+			const std::size_t end = i == 0 ? size - 1 : size;
+			std::size_t j = i + 2;
+			for (; j + LANES <= end; j += LANES) {
+				for (std::size_t lane = 0; lane < LANES; ++lane) {
+					const double omega = solidAngle(starts, ends, i, j + lane);
+					sums[lane] += omega;
+					absSums[lane] += fabs(omega);
+				}
+			}
+			for (std::size_t lane = 0; j < end; ++j, ++lane) {
+				const double omega = solidAngle(starts, ends, i, j);
+				sums[lane] += omega;
+				absSums[lane] += fabs(omega);
+			}
+		}
+		for (std::size_t lane = 0; lane < LANES; ++lane) {
+			signedSums[chunk] += sums[lane];
+			absoluteSums[chunk] += absSums[lane];
+		}
+		token.advance();
+	});
+
+	for (std::size_t chunk = 0; chunk < numberOfChunks; ++chunk) {
+		this->writhe += signedSums[chunk];
+		this->averageCrossingNumber += absoluteSums[chunk];
+	}
+	// Каждая пара входит в сумму по i != j дважды.
+	this->writhe /= 2 * M_PI;
+	this->averageCrossingNumber /= 2 * M_PI;
+}
+
+}
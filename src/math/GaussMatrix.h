@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 1995-2021, Nikolay Pultsin <geometer@geometer.name>
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __KE_MATH_GAUSS_MATRIX_H__
+#define __KE_MATH_GAUSS_MATRIX_H__
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "computable.h"
+
+namespace KE::ThreeD::Math {
+
+// ``Гауссовы произведения'' пар рёбер: gauss(i, j) = det(t_i, t_j, c_ij) / |c_ij|^3,
+// где t -- векторы рёбер, c_ij -- хорда между серединами рёбер i и j.
+// The kernel keeps O(n) data and computes any product on request;
+// gauss(i, j) and gauss(j, i) are computed in the same way, so they are
+// equal bit to bit.
+class GaussKernel {
+
+private:
+	// doubled edge middles and edge vectors
+	PointArray middles, tangents;
+
+public:
+	GaussKernel(const Knot::Snapshot &snapshot);
+
+	std::size_t size() const { return this->middles.size(); }
+	double operator()(std::size_t i, std::size_t j) const {
+		return i > j ? this->product(i, j) : j > i ? this->product(j, i) : 0.0;
+	}
+	// row[j] = gauss(i, j) for every j
+	void row(std::size_t i, double *row) const;
+
+private:
+	double product(std::size_t i, std::size_t j) const {
+		const double cx = (this->middles.x()[i] - this->middles.x()[j]) / 2;
+		const double cy = (this->middles.y()[i] - this->middles.y()[j]) / 2;
+		const double cz = (this->middles.z()[i] - this->middles.z()[j]) / 2;
+		const double chord_len = sqrt(cx * cx + cy * cy + cz * cz);
+		const double *tx = this->tangents.x(), *ty = this->tangents.y(), *tz = this->tangents.z();
+		// tangent[i] * (tangent[j] x chord)
+		const double triple =
+			tx[i] * (ty[j] * cz - tz[j] * cy) +
+			ty[i] * (tz[j] * cx - tx[j] * cz) +
+			tz[i] * (tx[j] * cy - ty[j] * cx);
+		return triple / (chord_len * chord_len * chord_len);
+	}
+};
+
+// The dense symmetric matrix of the Gauss products. Use
+// GaussMatrix::cached() to share it between the computables.
+class GaussMatrix {
+
+public:
+	// Larger knots are not stored densely (a 4096-point matrix takes 128 MB).
+	static constexpr std::size_t MAX_SIZE = 4096;
+
+private:
+	const std::size_t _size;
+	// row-major, size x size
+	std::vector<double> values;
+
+public:
+	// The matrix of the snapshot, computed on the first call; nullptr
+	// (and nothing is cached) if the token is cancelled meanwhile.
+	static std::shared_ptr<const GaussMatrix> cached(const Knot::Snapshot &snapshot, ComputationToken &token);
+
+	// Stops (leaving the matrix incomplete) if the token is cancelled.
+	GaussMatrix(const Knot::Snapshot &snapshot, const ComputationToken &token);
+
+	std::size_t size() const { return this->_size; }
+	const double *row(std::size_t i) const { return this->values.data() + i * this->_size; }
+	double operator()(std::size_t i, std::size_t j) const { return this->values[i * this->_size + j]; }
+};
+
+// Sequential access to the rows of the Gauss matrix with O(n * TILE_SIZE)
+// memory: the rows are taken from the shared GaussMatrix if the knot is
+// small enough, or computed (in parallel) by tiles of TILE_SIZE rows.
+// Both ways give the same values.
+class GaussRows {
+
+public:
+	static constexpr std::size_t TILE_SIZE = 64;
+
+private:
+	std::shared_ptr<const GaussMatrix> matrix;
+	std::unique_ptr<GaussKernel> kernel;
+	std::vector<double> tile;
+	std::size_t tileBegin, tileEnd;
+
+public:
+	GaussRows(const Knot::Snapshot &snapshot, ComputationToken &token);
+
+	// Must not be called after the token is cancelled.
+	// The pointer is valid until the next call for a row from another tile.
+	const double *row(std::size_t i);
+};
+
+// The Gauss integral over every pair of straight edges, computed exactly:
+// for two segments it is the solid angle of the quadrangle of the vectors
+// between their ends, divided by 4 pi. The integrand does not change sign
+// on a pair of segments, so the same terms give the exact (polygonal)
+// writhe and average crossing number. Use SegmentGaussIntegrals::cached().
+class SegmentGaussIntegrals {
+
+public:
+	double writhe;
+	double averageCrossingNumber;
+
+public:
+	// As GaussMatrix::cached(); reports the progress to the token.
+	static std::shared_ptr<const SegmentGaussIntegrals> cached(const Knot::Snapshot &snapshot, ComputationToken &token);
+
+	// Stops (leaving the sums incomplete) if the token is cancelled.
+	SegmentGaussIntegrals(const Knot::Snapshot &snapshot, ComputationToken &token);
+};
+
+}
+
+#endif /* __KE_MATH_GAUSS_MATRIX_H__ */
@@ -15,6 +15,7 @@
  */
 
 #include "computables.h"
+#include "GaussMatrix.h"
 #include "../ke/KnotWrapper.h"
 
 namespace KE::ThreeD::Math {
@@ -24,32 +25,37 @@ AverageCrossingNumber::AverageCrossingNumber(const KnotWrapper &knot, bool withS
 	withSign(withSign) {
 }
 
-double AverageCrossingNumber::compute(const Knot::Snapshot &snapshot) {
-	double value = 0.0;
+double AverageCrossingNumber::compute(const Knot::Snapshot &snapshot, ComputationToken &token) {
+	const std::size_t size = snapshot.size();
+	GaussRows gauss(snapshot, token);
 
-	// tangent vectors
-	std::vector<Vector> tangents;
-	for (std::size_t i = 0; i < snapshot.size(); ++i) {
-		tangents.push_back(Vector(snapshot[i], snapshot[snapshot.next(i)]));
-	}
+	constexpr std::size_t LANES = PointArray::simdWidth;
+	double sums[LANES] = {0.0};
+	double absSums[LANES] = {0.0};
 
-	for (std::size_t i = 0; i < snapshot.size(); ++i) {
-		for (std::size_t j = 0; j < i; ++j) {
-			const Vector chord(
-				(snapshot[i].x + snapshot[snapshot.next(i)].x - snapshot[j].x - snapshot[snapshot.next(j)].x) / 2,
-				(snapshot[i].y + snapshot[snapshot.next(i)].y - snapshot[j].y - snapshot[snapshot.next(j)].y) / 2,
-				(snapshot[i].z + snapshot[snapshot.next(i)].z - snapshot[j].z - snapshot[snapshot.next(j)].z) / 2
-			);
-			const double chord_len = chord.length();
-			const double summand = tangents[i].scalar_product(tangents[j].vector_product(chord)) / (chord_len * chord_len * chord_len);
-			if (this->withSign) {
-				value += summand;
-			} else {
-				value += fabs(summand);
+	token.start(size);
+	for (std::size_t i = 0; i < size; ++i, token.advance()) {
+		if (token.isCancelled()) {
+			return 0.0;
+		}
+		const double *row = gauss.row(i);
+		std::size_t j = 0;
+		for (; j + LANES <= i; j += LANES) {
+			for (std::size_t lane = 0; lane < LANES; ++lane) {
+				sums[lane] += row[j + lane];
+				absSums[lane] += fabs(row[j + lane]);
 			}
 		}
+		for (std::size_t lane = 0; j < i; ++j, ++lane) {
+			sums[lane] += row[j];
+			absSums[lane] += fabs(row[j]);
+		}
 	}
 
+	double value = 0.0;
+	for (std::size_t lane = 0; lane < LANES; ++lane) {
+		value += this->withSign ? sums[lane] : absSums[lane];
+	}
 	return value / (2 * M_PI);
 }
 
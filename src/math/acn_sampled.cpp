@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 1995-2021, Nikolay Pultsin <geometer@geometer.name>
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <random>
+
+#include "computables.h"
+#include "../ke/KnotWrapper.h"
+#include "../ke/ThreadPool.h"
+
+namespace KE::ThreeD::Math {
+
+namespace {
+
+// directions counted in parallel at once
+const std::size_t BATCH_SIZE = 64;
+// the first check of the interval; later checks are made each time
+// the number of samples doubles
+const std::size_t MIN_SAMPLES = 1024;
+
+// Плоская проекция ломаной и буферы для заметания.
+class Projection {
+
+private:
+	std::vector<double> x, y;
+	// левый конец ребра по x и номер ребра
+	std::vector<std::pair<double,std::size_t>> order;
+	std::vector<double> right;
+	std::vector<std::size_t> active;
+
+public:
+	// Число пересечений несмежных рёбер в проекции вдоль direction.
+	// Рёбра перебираются в порядке левых концов; каждое сравнивается только
+	// с рёбрами, которые ещё не кончились по x, то есть время -- O(n log n)
+	// плюс число пар рёбер, пересекающихся по x.
+	std::size_t crossings(const Knot::Snapshot &snapshot, const Vector &direction) {
+		const std::size_t size = snapshot.size();
+		Vector u = std::fabs(direction.x) < 0.5 ? direction.vector_product(Vector(1.0, 0.0, 0.0)) : direction.vector_product(Vector(0.0, 1.0, 0.0));
+		u.normalize();
+		const Vector v = direction.vector_product(u);
+
+		const auto &points = snapshot.points();
+		this->x.resize(size);
+		this->y.resize(size);
+		for (std::size_t i = 0; i < size; ++i) {
+			const Vector p(points.x()[i], points.y()[i], points.z()[i]);
+			this->x[i] = p.scalar_product(u);
+			this->y[i] = p.scalar_product(v);
+		}
+		this->order.resize(size);
+		this->right.resize(size);
+		for (std::size_t i = 0; i < size; ++i) {
+			const std::size_t next = snapshot.next(i);
+			this->order[i] = std::make_pair(std::min(this->x[i], this->x[next]), i);
+			this->right[i] = std::max(this->x[i], this->x[next]);
+		}
+		std::sort(this->order.begin(), this->order.end());
+
+		std::size_t count = 0;
+		this->active.clear();
+		for (const auto &[start, i] : this->order) {
+			std::size_t kept = 0;
+			for (std::size_t j : this->active) {
+				if (this->right[j] < start) {
+					continue;
+				}
+				this->active[kept++] = j;
+				if (j != snapshot.next(i) && i != snapshot.next(j) && this->intersects(snapshot, i, j)) {
+					count += 1;
+				}
+			}
+			this->active.resize(kept);
+			this->active.push_back(i);
+		}
+		return count;
+	}
+
+private:
+	// Знак ориентации треугольника (a, b, c).
+	double orientation(std::size_t a, std::size_t b, std::size_t c) const {
+		return (this->x[b] - this->x[a]) * (this->y[c] - this->y[a]) - (this->y[b] - this->y[a]) * (this->x[c] - this->x[a]);
+	}
+
+	bool intersects(const Knot::Snapshot &snapshot, std::size_t i, std::size_t j) const {
+		const std::size_t ni = snapshot.next(i), nj = snapshot.next(j);
+		return
+			this->orientation(i, ni, j) * this->orientation(i, ni, nj) < 0 &&
+			this->orientation(j, nj, i) * this->orientation(j, nj, ni) < 0;
+	}
+};
+
+}
+
+SampledCrossingNumber::SampledCrossingNumber(const KnotWrapper &knot, double precision, std::size_t maxSamples) :
+	Computable(knot, "Average crossing number (sampled)"),
+	precision(precision),
+	maxSamples(maxSamples),
+	estimateKey(Knot::Snapshot::newKey()) {
+}
+
+double SampledCrossingNumber::compute(const Knot::Snapshot &snapshot, ComputationToken &token) {
+	const auto estimate = this->estimate(snapshot, token);
+	return estimate ? estimate->mean : 0.0;
+}
+
+std::shared_ptr<const SampledCrossingNumber::Estimate> SampledCrossingNumber::estimate(const Knot::Snapshot &snapshot, ComputationToken &token) {
+	return std::static_pointer_cast<const Estimate>(snapshot.cachedValue(this->estimateKey, 0, [this, &snapshot, &token]() -> std::shared_ptr<const void> {
+		auto estimate = std::make_shared<const Estimate>(this->sample(snapshot, token));
+		return token.isCancelled() ? nullptr : estimate;
+	}));
+}
+
+std::shared_ptr<const SampledCrossingNumber::Estimate> SampledCrossingNumber::estimate() {
+	ComputationToken token;
+	return this->estimate(*this->currentSnapshot(), token);
+}
+
+SampledCrossingNumber::Estimate SampledCrossingNumber::sample(const Knot::Snapshot &snapshot, ComputationToken &token) const {
+	Estimate estimate;
+
+	std::mt19937_64 generator(0);
+	std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+	std::vector<Vector> directions;
+	std::vector<std::size_t> counts;
+	double sum = 0.0, squares = 0.0;
+	std::size_t nextCheck = MIN_SAMPLES;
+
+	// Число нужных направлений заранее неизвестно; прогресс -- доля
+	// до ближайшей проверки интервала.
+	token.start(std::min(nextCheck, this->maxSamples));
+	while (estimate.numberOfSamples < this->maxSamples) {
+		if (token.isCancelled()) {
+			return estimate;
+		}
+		// Равномерное распределение на сфере: z и азимут равномерны.
+		const std::size_t batch = std::min(BATCH_SIZE, this->maxSamples - estimate.numberOfSamples);
+		directions.clear();
+		for (std::size_t k = 0; k < batch; ++k) {
+			const double z = uniform(generator);
+			const double phi = M_PI * uniform(generator);
+			const double r = sqrt(1 - z * z);
+			directions.push_back(Vector(r * cos(phi), r * sin(phi), z));
+		}
+		counts.assign(batch, 0);
+		Util::ThreadPool::shared().run(batch, [&](std::size_t k) {
+			Projection projection;
+			counts[k] = projection.crossings(snapshot, directions[k]);
+		});
+		token.advance(batch);
+
+		for (std::size_t k = 0; k < batch; ++k) {
+			if (estimate.numberOfSamples == 0 || counts[k] < estimate.minCrossings) {
+				estimate.minCrossings = counts[k];
+				estimate.minDirection = directions[k];
+			}
+			estimate.numberOfSamples += 1;
+			sum += counts[k];
+			squares += (double)counts[k] * counts[k];
+		}
+
+		const double n = estimate.numberOfSamples;
+		estimate.mean = sum / n;
+		const double variance = n > 1 ? std::max(squares - sum * sum / n, 0.0) / (n - 1) : 0.0;
+		estimate.halfWidth = 1.96 * sqrt(variance / n);
+		// Проверка после каждой порции смещает оценку: остановка чаще
+		// случается на случайно завышенном среднем, для которого
+		// относительная точность достигается раньше. Поэтому интервал
+		// проверяется редко -- при удвоении числа направлений, начиная
+		// с MIN_SAMPLES, -- и всего получается не больше log2 проверок.
+		if (estimate.numberOfSamples >= nextCheck) {
+			if (estimate.halfWidth <= this->precision * estimate.mean) {
+				break;
+			}
+			nextCheck *= 2;
+			token.start(std::min(nextCheck, this->maxSamples));
+			token.advance(estimate.numberOfSamples);
+		}
+	}
+
+	return estimate;
+}
+
+}
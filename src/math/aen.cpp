@@ -23,7 +23,7 @@ AverageExtremumNumber::AverageExtremumNumber(const KnotWrapper &knot) :
 	Computable(knot, "Average extremum number") {
 }
 
-double AverageExtremumNumber::compute(const Knot::Snapshot &snapshot) {
+double AverageExtremumNumber::compute(const Knot::Snapshot &snapshot, ComputationToken&) {
 	const auto &edgeLengths = snapshot.edgeLengths();
 
 	std::vector<Vector> edges;
@@ -19,13 +19,38 @@
 
 namespace KE::ThreeD::Math {
 
+std::shared_ptr<Knot::Snapshot> Computable::currentSnapshot() const {
+	return std::make_shared<Knot::Snapshot>(this->knot.snapshot());
+}
+
 double Computable::value() {
-	if (!this->snapshot || this->snapshot->isObsolete()) {
-		this->snapshot = std::make_shared<Knot::Snapshot>(this->knot.snapshot());
-		this->_value = this->compute(*this->snapshot);
+	double value;
+	if (!this->cachedValue(value)) {
+		ComputationToken token;
+		this->value(this->currentSnapshot(), token, value);
 	}
+	return value;
+}
 
-	return this->_value;
+bool Computable::value(const std::shared_ptr<Knot::Snapshot> &snapshot, ComputationToken &token, double &value) {
+	const auto cached = snapshot->cachedValue(this->key, 0, [this, &snapshot, &token]() -> std::shared_ptr<const void> {
+		const double value = this->compute(*snapshot, token);
+		return token.isCancelled() ? nullptr : std::make_shared<const double>(value);
+	});
+	if (!cached) {
+		return false;
+	}
+	value = *std::static_pointer_cast<const double>(cached);
+	return true;
+}
+
+bool Computable::cachedValue(double &value) const {
+	const auto cached = this->knot.snapshot().storedValue(this->key, 0);
+	if (!cached) {
+		return false;
+	}
+	value = *std::static_pointer_cast<const double>(cached);
+	return true;
 }
 
 }
@@ -17,6 +17,9 @@
 #ifndef __KE_MATH_COMPUTABLE_H__
 #define __KE_MATH_COMPUTABLE_H__
 
+#include <algorithm>
+#include <atomic>
+
 #include "../ke/Knot.h"
 
 namespace KE::ThreeD {
@@ -27,6 +30,37 @@ class KnotWrapper;
 
 namespace KE::ThreeD::Math {
 
+// Shared by the caller of a computation and the computation itself:
+// the caller may cancel it at any moment, the computation checks
+// isCancelled() at convenient points and reports its progress.
+// The value returned by a cancelled computation is ignored.
+class ComputationToken {
+
+private:
+	std::atomic<bool> cancelled;
+	std::atomic<std::size_t> done;
+	std::atomic<std::size_t> total;
+
+public:
+	ComputationToken() : cancelled(false), done(0), total(0) {}
+
+	void cancel() { this->cancelled = true; }
+	bool isCancelled() const { return this->cancelled; }
+
+	// The computation consists of total equal steps; advance() may be
+	// called from several threads (e.g., by the thread pool tasks).
+	void start(std::size_t total) {
+		this->done = 0;
+		this->total = total;
+	}
+	void advance(std::size_t steps = 1) { this->done += steps; }
+	// In [0, 1]; 0 if the computation does not report its progress.
+	double progress() const {
+		const std::size_t total = this->total;
+		return total ? std::min(1.0, (double)this->done / total) : 0.0;
+	}
+};
+
 class Computable {
 
 public:
@@ -34,17 +68,26 @@ public:
 
 private:
 	const KnotWrapper &knot;
-	std::shared_ptr<Knot::Snapshot> snapshot;
-	double _value;
+	// The values are kept in the snapshot cache under this key.
+	const std::size_t key;
 
 protected:
-	virtual double compute(const Knot::Snapshot &snapshot) = 0;
+	virtual double compute(const Knot::Snapshot &snapshot, ComputationToken &token) = 0;
 
 public:
-	Computable(const KnotWrapper &knot, const std::string &name) : name(name), knot(knot) {}
+	Computable(const KnotWrapper &knot, const std::string &name) : name(name), knot(knot), key(Knot::Snapshot::newKey()) {}
 	virtual ~Computable() {}
 
+	std::shared_ptr<Knot::Snapshot> currentSnapshot() const;
+
+	// The value for the current knot; computed in the calling thread
+	// if the knot has been changed since the last computation.
 	double value();
+	// The value for the snapshot; false if the computation has been
+	// cancelled. Computed once per snapshot, like the other derived data.
+	bool value(const std::shared_ptr<Knot::Snapshot> &snapshot, ComputationToken &token, double &value);
+	// The value for the current knot, if it is already computed.
+	bool cachedValue(double &value) const;
 };
 
 }
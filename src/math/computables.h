@@ -18,6 +18,7 @@
 #define __COMPUTABLES_H__
 
 #include "computable.h"
+#include "../ke/EnergyKernel.h"
 
 namespace KE::ThreeD {
 
@@ -33,16 +34,82 @@ public:
 	const bool withSign;
 
 private:
-	double compute(const Knot::Snapshot &snapshot) override;
+	double compute(const Knot::Snapshot &snapshot, ComputationToken &token) override;
 
 public:
 	AverageCrossingNumber(const KnotWrapper &knot, bool withSign);
 };
 
+// Monte-Carlo estimate of the average crossing number: the crossings of
+// projections to random planes are counted, until the 95% confidence
+// interval of the mean is within precision (relative) or maxSamples
+// directions are used. The interval is checked at 1024 directions and then
+// each time their number doubles, so at least 1024 directions are counted;
+// the progress is reported against the next check. The directions are
+// pseudo-random with a fixed seed, so the estimate is reproducible.
+class SampledCrossingNumber : public Computable {
+
+public:
+	struct Estimate {
+		double mean;
+		// half-width of the 95% confidence interval
+		double halfWidth;
+		std::size_t numberOfSamples;
+		// the projection with the fewest crossings among the sampled ones
+		std::size_t minCrossings;
+		Vector minDirection;
+
+		Estimate() : mean(0.0), halfWidth(0.0), numberOfSamples(0), minCrossings(0), minDirection(0.0, 0.0, 1.0) {}
+	};
+
+public:
+	const double precision;
+	const std::size_t maxSamples;
+
+private:
+	// The estimates are kept in the snapshot cache under this key.
+	const std::size_t estimateKey;
+
+private:
+	double compute(const Knot::Snapshot &snapshot, ComputationToken &token) override;
+	Estimate sample(const Knot::Snapshot &snapshot, ComputationToken &token) const;
+
+public:
+	SampledCrossingNumber(const KnotWrapper &knot, double precision = 0.05, std::size_t maxSamples = 100000);
+
+	// Details of the estimate returned by value(); computed once
+	// per snapshot, nullptr if cancelled.
+	std::shared_ptr<const Estimate> estimate(const Knot::Snapshot &snapshot, ComputationToken &token);
+	// The same for the current knot, computed in the calling thread if needed.
+	std::shared_ptr<const Estimate> estimate();
+};
+
+// Writhe of the polygon, with the exact Gauss integral for every pair
+// of edges (see SegmentGaussIntegrals).
+class Writhe : public Computable {
+
+private:
+	double compute(const Knot::Snapshot &snapshot, ComputationToken &token) override;
+
+public:
+	Writhe(const KnotWrapper &knot);
+};
+
+// The same for the average crossing number; unlike AverageCrossingNumber,
+// exact for the polygon itself, so it needs far fewer points.
+class ExactAverageCrossingNumber : public Computable {
+
+private:
+	double compute(const Knot::Snapshot &snapshot, ComputationToken &token) override;
+
+public:
+	ExactAverageCrossingNumber(const KnotWrapper &knot);
+};
+
 class AverageExtremumNumber : public Computable {
 
 private:
-	double compute(const Knot::Snapshot &snapshot) override;
+	double compute(const Knot::Snapshot &snapshot, ComputationToken &token) override;
 
 public:
 	AverageExtremumNumber(const KnotWrapper &knot);
@@ -50,11 +117,42 @@ public:
 
 class MoebiusEnergy : public Computable {
 
+public:
+	// exact: all pairs, split between the shared pool threads;
+	// farField: see EnergyKernel::farFieldEnergy.
+	const EnergyKernel::Method method;
+	// Relative error bound of every far-field term; 0 for the exact method.
+	const double tolerance;
+
 private:
-	double compute(const Knot::Snapshot &snapshot) override;
+	double compute(const Knot::Snapshot &snapshot, ComputationToken &token) override;
 
 public:
-	MoebiusEnergy(const KnotWrapper &knot);
+	MoebiusEnergy(const KnotWrapper &knot, EnergyKernel::Method method = EnergyKernel::Method::exact, double tolerance = 0.1);
+};
+
+// Vassiliev invariants of orders minOrder..maxOrder; the power series
+// for all the orders are accumulated in the same sweep over the Gauss
+// products, so the whole range costs about as much as one order.
+class VassilievInvariants {
+
+public:
+	const int minOrder;
+	const int maxOrder;
+
+private:
+	// The values are kept in the snapshot cache under this key.
+	const std::size_t key;
+
+public:
+	// If the token is cancelled, returns whatever has been accumulated.
+	static std::vector<double> compute(const Knot::Snapshot &snapshot, int minOrder, int maxOrder, ComputationToken &token);
+
+	VassilievInvariants(int minOrder, int maxOrder);
+
+	// values[k] is the invariant of order minOrder + k;
+	// computed once per snapshot (unless cancelled).
+	std::vector<double> values(const Knot::Snapshot &snapshot, ComputationToken &token);
 };
 
 class VassilievInvariant : public Computable {
@@ -63,10 +161,15 @@ public:
 	const int order;
 
 private:
-	double compute(const Knot::Snapshot &snapshot) override;
+	const std::shared_ptr<VassilievInvariants> series;
+
+private:
+	double compute(const Knot::Snapshot &snapshot, ComputationToken &token) override;
 
 public:
 	VassilievInvariant(const KnotWrapper &knot, int order);
+	// Takes the value from the series shared with the other orders.
+	VassilievInvariant(const KnotWrapper &knot, const std::shared_ptr<VassilievInvariants> &series, int order);
 };
 
 }
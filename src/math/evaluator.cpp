@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 1995-2021, Nikolay Pultsin <geometer@geometer.name>
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+
+#include "evaluator.h"
+
+namespace KE::ThreeD::Math {
+
+Evaluator &Evaluator::shared() {
+	static Evaluator evaluator;
+	return evaluator;
+}
+
+Evaluator::Evaluator() : stopping(false) {
+	this->worker = std::thread([this] { this->workerLoop(); });
+}
+
+Evaluator::~Evaluator() {
+	{
+		std::lock_guard<std::mutex> guard(this->mutex);
+		this->stopping = true;
+		for (const auto &request : this->queue) {
+			request->_state = Request::State::cancelled;
+		}
+		this->queue.clear();
+		if (this->running) {
+			this->running->token.cancel();
+		}
+	}
+	this->requestAdded.notify_all();
+	this->worker.join();
+}
+
+std::shared_ptr<Evaluator::Request> Evaluator::request(const std::shared_ptr<Computable> &computable) {
+	const auto request = std::make_shared<Request>(computable, computable->currentSnapshot());
+	{
+		std::lock_guard<std::mutex> guard(this->mutex);
+		this->queue.push_back(request);
+	}
+	this->requestAdded.notify_all();
+	return request;
+}
+
+void Evaluator::cancel(const std::shared_ptr<Request> &request) {
+	std::lock_guard<std::mutex> guard(this->mutex);
+	request->token.cancel();
+	const auto position = std::find(this->queue.begin(), this->queue.end(), request);
+	if (position != this->queue.end()) {
+		this->queue.erase(position);
+		request->_state = Request::State::cancelled;
+	}
+}
+
+void Evaluator::wait(const std::shared_ptr<Request> &request) {
+	std::unique_lock<std::mutex> lock(this->mutex);
+	this->requestFinished.wait(lock, [this, &request] { return this->running != request; });
+}
+
+// Запросы с устаревшим снимком тоже вычисляются: если отбрасывать их, то
+// при частых изменениях узла медленные величины не досчитаются никогда.
+void Evaluator::workerLoop() {
+	std::unique_lock<std::mutex> lock(this->mutex);
+	while (true) {
+		this->requestAdded.wait(lock, [this] { return this->stopping || !this->queue.empty(); });
+		if (this->stopping) {
+			break;
+		}
+		const auto request = this->queue.front();
+		this->queue.pop_front();
+		this->running = request;
+		request->_state = Request::State::running;
+		lock.unlock();
+
+		double value = 0.0;
+		const bool finished = request->computable->value(request->snapshot, request->token, value);
+
+		lock.lock();
+		if (finished) {
+			request->_value = value;
+		}
+		request->_state = finished ? Request::State::finished : Request::State::cancelled;
+		this->running = nullptr;
+		this->requestFinished.notify_all();
+	}
+}
+
+}
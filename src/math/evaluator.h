@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 1995-2021, Nikolay Pultsin <geometer@geometer.name>
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __KE_MATH_EVALUATOR_H__
+#define __KE_MATH_EVALUATOR_H__
+
+#include <condition_variable>
+#include <deque>
+#include <thread>
+
+#include "computable.h"
+
+namespace KE::ThreeD::Math {
+
+// Computes the values of computables in a background thread, one request
+// at a time (every computation splits its work between the shared thread
+// pool threads by itself). Every request is computed to the end unless
+// it is cancelled, even if its snapshot becomes obsolete: while the knot
+// changes faster than a computation runs, the caller gets a stale value
+// rather than none.
+class Evaluator {
+
+public:
+	class Request {
+
+	friend class Evaluator;
+
+	public:
+		enum class State {
+			pending,
+			running,
+			finished,
+			// cancelled by the caller or by the evaluator destruction
+			cancelled
+		};
+
+	public:
+		const std::shared_ptr<Computable> computable;
+		const std::shared_ptr<Knot::Snapshot> snapshot;
+
+	private:
+		ComputationToken token;
+		std::atomic<State> _state;
+		double _value;
+
+	public:
+		Request(const std::shared_ptr<Computable> &computable, const std::shared_ptr<Knot::Snapshot> &snapshot) : computable(computable), snapshot(snapshot), _state(State::pending), _value(0.0) {}
+
+		State state() const { return this->_state; }
+		bool isActive() const { return this->_state == State::pending || this->_state == State::running; }
+		double progress() const { return this->token.progress(); }
+		// Valid if the state is finished.
+		double value() const { return this->_value; }
+	};
+
+private:
+	std::mutex mutex;
+	std::condition_variable requestAdded;
+	std::condition_variable requestFinished;
+	std::deque<std::shared_ptr<Request>> queue;
+	std::shared_ptr<Request> running;
+	bool stopping;
+	std::thread worker;
+
+public:
+	static Evaluator &shared();
+
+	Evaluator();
+	~Evaluator();
+
+	// Queues the computation of the value for the current knot snapshot.
+	std::shared_ptr<Request> request(const std::shared_ptr<Computable> &computable);
+	// Cancels the request and returns at once; a running computation
+	// stops at its next check of the token.
+	void cancel(const std::shared_ptr<Request> &request);
+	// Waits until the computation of the request stops, if it is running;
+	// after that the knot of the snapshot may be destroyed.
+	void wait(const std::shared_ptr<Request> &request);
+
+private:
+	void workerLoop();
+
+private:
+	Evaluator(const Evaluator&) = delete;
+	Evaluator& operator = (const Evaluator&) = delete;
+};
+
+}
+
+#endif /* __KE_MATH_EVALUATOR_H__ */
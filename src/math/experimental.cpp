@@ -14,8 +14,12 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <cmath>
+
 #include "experimental.h"
 #include "../ke/KnotWrapper.h"
+#include "../ke/ThreadPool.h"
 
 namespace KE::ThreeD::Math {
 
@@ -127,95 +131,112 @@ Experimental::Experimental(const KnotWrapper &knot) : Computable(knot, "Experime
 //	return value / (4 * M_PI * M_PI);
 //}
 
-double Experimental::compute(const Knot::Snapshot &snapshot) {
-	double value = 0.0;
-
-	// Вычисляем заранее касательные векторы.
-	double **tangs = new double*[snapshot.size()];
-	for (std::size_t i1 = 0; i1 < snapshot.size(); i1++) {
-		tangs[i1] = new double[3];
-		tangs[i1][0] = snapshot[snapshot.next(i1)].x - snapshot[i1].x;
-		tangs[i1][1] = snapshot[snapshot.next(i1)].y - snapshot[i1].y;
-		tangs[i1][2] = snapshot[snapshot.next(i1)].z - snapshot[i1].z;
-	}
+namespace {
 
-	// Вычисляем ``гауссовы произведения''.
-	double chord_len;
-	double ***chord = new double**[snapshot.size()];
-	double ***vector = new double**[snapshot.size()];
-	double **sum = new double*[snapshot.size()];
-
-	for (std::size_t i1 = 0; i1 < snapshot.size(); i1++) {
-		chord[i1] = new double*[snapshot.size()];
-		vector[i1] = new double*[snapshot.size()];
-		sum[i1] = new double[snapshot.size()];
-		for (std::size_t i2 = 0; i2 < snapshot.size(); i2++) {
-			chord[i1][i2] = new double[3];
-			vector[i1][i2] = new double[3];
+// Хорда между серединами рёбер i1 и i2 (единичная) и векторное произведение
+// касательных, делённое на квадрат длины хорды. Для i1 < i2 -- отражение
+// значений для (i2, i1), как при заполнении матриц целиком.
+struct ChordAndVector {
+	double chord[3];
+	double vector[3];
+
+	ChordAndVector(const Knot::Snapshot &snapshot, std::size_t i1, std::size_t i2) {
+		const std::size_t from = std::max(i1, i2), to = std::min(i1, i2);
+		const auto &points = snapshot.points();
+		const double *coords[3] = {points.x(), points.y(), points.z()};
+		const std::size_t nextFrom = snapshot.next(from), nextTo = snapshot.next(to);
+		double tangFrom[3], tangTo[3];
+		for (int k = 0; k < 3; k++) {
+			this->chord[k] = (coords[k][from] + coords[k][nextFrom] - coords[k][to] - coords[k][nextTo]) / 2;
+			tangFrom[k] = coords[k][nextFrom] - coords[k][from];
+			tangTo[k] = coords[k][nextTo] - coords[k][to];
 		}
-
-		for (std::size_t i2 = 0; i2 < i1; i2++) {
-			chord[i1][i2][0] = ( snapshot[i1].x + snapshot[snapshot.next(i1)].x -
-										snapshot[i2].x - snapshot[snapshot.next(i2)].x ) / 2;
-			chord[i1][i2][1] = ( snapshot[i1].y + snapshot[snapshot.next(i1)].y -
-										snapshot[i2].y - snapshot[snapshot.next(i2)].y ) / 2;
-			chord[i1][i2][2] = ( snapshot[i1].z + snapshot[snapshot.next(i1)].z -
-										snapshot[i2].z - snapshot[snapshot.next(i2)].z ) / 2;
-			chord_len = sqrt (vector_square (chord[i1][i2]));
-			chord[i1][i2][0] /= chord_len;
-			chord[i1][i2][1] /= chord_len;
-			chord[i1][i2][2] /= chord_len;
-			chord[i2][i1][0] = - chord[i1][i2][0];
-			chord[i2][i1][1] = - chord[i1][i2][1];
-			chord[i2][i1][2] = - chord[i1][i2][2];
-			vector_product (tangs[i1], tangs[i2], vector[i1][i2]);
-			chord_len *= chord_len;
-			vector[i1][i2][0] /= chord_len;
-			vector[i1][i2][1] /= chord_len;
-			vector[i1][i2][2] /= chord_len;
-			vector[i2][i1][0] = - vector[i1][i2][0];
-			vector[i2][i1][1] = - vector[i1][i2][1];
-			vector[i2][i1][2] = - vector[i1][i2][2];
+		double chord_len = sqrt (vector_square (this->chord));
+		for (int k = 0; k < 3; k++) {
+			this->chord[k] /= chord_len;
+		}
+		vector_product (tangFrom, tangTo, this->vector);
+		chord_len *= chord_len;
+		for (int k = 0; k < 3; k++) {
+			this->vector[k] /= chord_len;
+		}
+		if (from != i1) {
+			for (int k = 0; k < 3; k++) {
+				this->chord[k] = - this->chord[k];
+				this->vector[k] = - this->vector[k];
+			}
 		}
 	}
+};
 
-	for (int i = 0; i < 3; ++i) {
-		for (int j = 0; j < 3; ++j) {
-			for (std::size_t i1 = 0; i1 < snapshot.size(); i1++) {
-				sum[i1][i1] = 0.0;
-				for (std::size_t i2 = snapshot.next(i1); i2 != i1; i2 = snapshot.next(i2)) {
-					sum[i1][i2] = sum[i1][snapshot.prev(i2)] + chord[i1][i2][i] * vector[i1][i2][j];
-				}
-			}
+// Девять произведений компонент chord[i] * vector[j].
+const int COMPONENTS = 9;
 
-			for (std::size_t i1 = 0; i1 < snapshot.size(); i1++) {
-				double tmp = 0.0;
+}
 
-				for (std::size_t i2 = snapshot.next(snapshot.next(i1)); i2 != i1; i2 = snapshot.next(i2)) {
-					tmp += sum[snapshot.prev(i2)][snapshot.prev(i1)] - sum[snapshot.prev(i2)][i2] - sum[i2][snapshot.prev(snapshot.prev(i2))] + sum[i2][i1];
-					value += tmp * vector[i2][i1][j] * chord[i2][i1][i];
+// Все девять пар компонент (i, j) считаются за один проход: в sum для каждой
+// пары (i1, i2) подряд лежат девять префиксных сумм. Строки sum и слагаемые
+// для разных i1 независимы и делятся между потоками; частичные суммы по i1
+// складываются в фиксированном порядке, так что результат не зависит
+// от числа потоков.
+double Experimental::compute(const Knot::Snapshot &snapshot, ComputationToken &token) {
+	const std::size_t size = snapshot.size();
+	PointArray::Coordinates sum(COMPONENTS * size * size);
+	const auto at = [&sum, size](std::size_t i1, std::size_t i2) {
+		return sum.data() + COMPONENTS * (i1 * size + i2);
+	};
+
+	token.start(2 * size);
+	Util::ThreadPool::shared().run(size, [&](std::size_t i1) {
+		if (token.isCancelled()) {
+			return;
+		}
+		std::fill(at(i1, i1), at(i1, i1) + COMPONENTS, 0.0);
+		for (std::size_t i2 = snapshot.next(i1); i2 != i1; i2 = snapshot.next(i2)) {
+			const ChordAndVector cv(snapshot, i1, i2);
+			const double *previous = at(i1, snapshot.prev(i2));
+			double *current = at(i1, i2);
+			for (int i = 0; i < 3; ++i) {
+				for (int j = 0; j < 3; ++j) {
+					current[3 * i + j] = previous[3 * i + j] + cv.chord[i] * cv.vector[j];
 				}
 			}
 		}
+		token.advance();
+	});
+	if (token.isCancelled()) {
+		return 0.0;
 	}
 
-	// Удаляем заранее вычисленные вспомогательные значения.
-	for (std::size_t i1 = 0; i1 < snapshot.size(); i1++) {
-		for (std::size_t i2 = 0; i2 < snapshot.size(); i2++) {
-			delete[] chord[i1][i2];
-			delete[] vector[i1][i2];
+	PointArray::Coordinates partial(COMPONENTS * size, 0.0);
+	Util::ThreadPool::shared().run(size, [&](std::size_t i1) {
+		if (token.isCancelled()) {
+			return;
 		}
+		double tmp[COMPONENTS] = {0.0};
+		double *value = partial.data() + COMPONENTS * i1;
+		const std::size_t p1 = snapshot.prev(i1);
+		for (std::size_t i2 = snapshot.next(snapshot.next(i1)); i2 != i1; i2 = snapshot.next(i2)) {
+			const ChordAndVector cv(snapshot, i2, i1);
+			const std::size_t p2 = snapshot.prev(i2);
+			const double *s1 = at(p2, p1), *s2 = at(p2, i2), *s3 = at(i2, snapshot.prev(p2)), *s4 = at(i2, i1);
+			for (int i = 0; i < 3; ++i) {
+				for (int j = 0; j < 3; ++j) {
+					const int k = 3 * i + j;
+					tmp[k] += s1[k] - s2[k] - s3[k] + s4[k];
+					value[k] += tmp[k] * cv.vector[j] * cv.chord[i];
+				}
+			}
+		}
+		token.advance();
+	});
 
-		delete[] tangs[i1];
-		delete[] chord[i1];
-		delete[] vector[i1];
-		delete[] sum[i1];
+	double value = 0.0;
+	for (int k = 0; k < COMPONENTS; ++k) {
+		for (std::size_t i1 = 0; i1 < size; i1++) {
+			value += partial[COMPONENTS * i1 + k];
+		}
 	}
-	delete[] tangs;
-	delete[] chord;
-	delete[] vector;
-	delete[] sum;
-
 	return value / (64 * M_PI);
 }
 
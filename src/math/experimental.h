@@ -30,7 +30,7 @@ namespace KE::ThreeD::Math {
 class Experimental : public Computable {
 
 private:
-	double compute(const Knot::Snapshot &snapshot) override;
+	double compute(const Knot::Snapshot &snapshot, ComputationToken &token) override;
 
 public:
 	Experimental(const KnotWrapper &knot);
@@ -39,7 +39,7 @@ public:
 class Singular : public Computable {
 
 private:
-	double compute(const Knot::Snapshot &snapshot) override;
+	double compute(const Knot::Snapshot &snapshot, ComputationToken &token) override;
 
 public:
 	Singular(const KnotWrapper &knot);
@@ -51,7 +51,7 @@ public:
 	const int order;
 
 private:
-	double compute(const Knot::Snapshot &snapshot) override;
+	double compute(const Knot::Snapshot &snapshot, ComputationToken &token) override;
 
 public:
 	Experimental2(const KnotWrapper &knot, int order);
@@ -14,68 +14,39 @@
  * limitations under the License.
  */
 
+#include <sstream>
+
 #include "computables.h"
 #include "../ke/KnotWrapper.h"
+#include "../ke/ThreadPool.h"
 
 namespace KE::ThreeD::Math {
 
-MoebiusEnergy::MoebiusEnergy(const KnotWrapper &knot) : Computable(knot, "Moebius energy") {
-}
-
-double MoebiusEnergy::compute(const Knot::Snapshot &snapshot) {
-	const auto &edgeLengths = snapshot.edgeLengths();
-	const double len = snapshot.knotLength();
-
-	double value = 0.0;
-
-	for (std::size_t i = 0; i < snapshot.size() - 2; ++i) {
-		double l = edgeLengths[i];
-		for (auto j = i + 2; j < (i ? snapshot.size() : snapshot.size() - 1); ++j) {
-			const Vector chord(snapshot[i], snapshot[j]);
-			double r2 = 0.65 / chord.square();
-
-			l += edgeLengths[snapshot.prev(j)];
-			if (2 * l < len) {
-				r2 -= 0.65 / (l * l);
-			} else {
-				r2 -= 0.65 / ((len - l) * (len - l));
-			}
+namespace {
 
-			value += (edgeLengths[snapshot.prev(i)] + edgeLengths[i]) *
-							 (edgeLengths[snapshot.prev(j)] + edgeLengths[j]) * r2;
-		}
-	}
-
-	std::vector<Point> middles;
-	middles.reserve(snapshot.size());
-	for (std::size_t i = 0; i < snapshot.size(); i++) {
-		middles.push_back(Point(
-			(snapshot[i].x + snapshot[snapshot.next(i)].x) / 2,
-			(snapshot[i].y + snapshot[snapshot.next(i)].y) / 2,
-			(snapshot[i].z + snapshot[snapshot.next(i)].z) / 2
-		));
+std::string energyName(EnergyKernel::Method method, double tolerance) {
+	if (method == EnergyKernel::Method::exact) {
+		return "Moebius energy";
 	}
+	std::ostringstream name;
+	name << "Moebius energy (far field, tolerance " << tolerance << ")";
+	return name.str();
+}
 
-	for (std::size_t i = 0; i < snapshot.size(); i++) {
-		double l = 0;
-		for (std::size_t j = i + 1; j < snapshot.size(); j++) {
-			const Vector r(middles[i], middles[j]);
-			double r2 = 2 / r.square();
+}
 
-			l += (edgeLengths[snapshot.prev(j)] + edgeLengths[j]) / 2;
-			if (2 * l < len) {
-				r2 -= 2 / (l * l);
-			} else {
-				r2 -= 2 / ( (len - l) * (len - l) );
-			}
+MoebiusEnergy::MoebiusEnergy(const KnotWrapper &knot, EnergyKernel::Method method, double tolerance) :
+	Computable(knot, energyName(method, tolerance)),
+	method(method),
+	tolerance(method == EnergyKernel::Method::exact ? 0.0 : tolerance) {
+}
 
-			value += edgeLengths[i] * edgeLengths[j] * r2;
-		}
+double MoebiusEnergy::compute(const Knot::Snapshot &snapshot, ComputationToken&) {
+	EnergyKernel kernel;
+	if (this->method == EnergyKernel::Method::farField) {
+		return kernel.farFieldEnergy(snapshot.points(), this->tolerance, Util::ThreadPool::shared());
 	}
-
-	value /= 2.3;
-	value -= 4;
-	return value;
+	return kernel.energy(snapshot.points(), Util::ThreadPool::shared());
 }
 
 }
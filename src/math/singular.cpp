@@ -14,8 +14,14 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <vector>
+
 #include "experimental.h"
 #include "../ke/KnotWrapper.h"
+#include "../ke/ThreadPool.h"
 
 namespace KE::ThreeD::Math {
 
@@ -41,6 +47,117 @@ bool inside(const double *a, const double *b, const double *c, const double *d,
 	return (det(b, c, x) > 0) == sign && (det(c, d, x) > 0) == sign && (det(d, a, x) > 0) == sign;
 }
 
+// Единичные хорды chord(i, j) = (p[i] - p[j]) / |p[i] - p[j]|, одним массивом.
+// Каждая строка chord(i, *) разбита на блоки по BLOCK_SIZE хорд; для блока
+// хранится радиус шара вокруг его первой хорды, в котором лежат остальные.
+class Chords {
+
+public:
+	static const std::size_t BLOCK_SIZE = 16;
+
+private:
+	const std::size_t size;
+	const std::size_t blocksPerRow;
+	std::vector<double> values;
+	std::vector<double> radii;
+
+public:
+	Chords(const Knot::Snapshot &snapshot) :
+		size(snapshot.size()),
+		blocksPerRow((snapshot.size() + BLOCK_SIZE - 1) / BLOCK_SIZE),
+		values(3 * snapshot.size() * snapshot.size(), 0.0),
+		radii(snapshot.size() * this->blocksPerRow, 0.0) {
+		const auto &points = snapshot.points();
+		Util::ThreadPool::shared().run(this->size, [this, &points](std::size_t i1) {
+			for (std::size_t i2 = 0; i2 < this->size; i2++) {
+				if (i2 == i1) {
+					continue;
+				}
+				// Хорда с большим номером первой точки считается, другая -- её отражение.
+				const std::size_t from = std::max(i1, i2), to = std::min(i1, i2);
+				double *chord = this->values.data() + 3 * (i1 * this->size + i2);
+				chord[0] = points.x()[from] - points.x()[to];
+				chord[1] = points.y()[from] - points.y()[to];
+				chord[2] = points.z()[from] - points.z()[to];
+				const double chord_len = sqrt(vector_square(chord));
+				for (int k = 0; k < 3; k++) {
+					chord[k] /= chord_len;
+					if (from != i1) {
+						chord[k] = - chord[k];
+					}
+				}
+			}
+			for (std::size_t block = 0; block < this->blocksPerRow; block++) {
+				const double *first = (*this)(i1, block * BLOCK_SIZE);
+				double radius = 0.0;
+				for (std::size_t i2 = block * BLOCK_SIZE; i2 < std::min((block + 1) * BLOCK_SIZE, this->size); i2++) {
+					const double *chord = (*this)(i1, i2);
+					const double diff[3] = {chord[0] - first[0], chord[1] - first[1], chord[2] - first[2]};
+					radius = std::max(radius, sqrt(vector_square(diff)));
+				}
+				this->radii[i1 * this->blocksPerRow + block] = radius;
+			}
+		});
+	}
+
+	const double *operator()(std::size_t i1, std::size_t i2) const {
+		return this->values.data() + 3 * (i1 * this->size + i2);
+	}
+
+	// Вызывает visit(j) для всех j из [begin, end), для которых
+	// |(direction, chord(i, j))| >= min_cos. Для хорды x из блока с первой
+	// хордой f |(direction, x)| <= |(direction, f)| + |x - f|, поэтому блоки,
+	// где эта оценка меньше min_cos, пропускаются целиком; запас покрывает
+	// ошибки округления.
+	template<typename Visitor>
+	void forParallel(std::size_t i, std::size_t begin, std::size_t end, const double *direction, double min_cos, const Visitor &visit) const {
+		for (std::size_t block = begin / BLOCK_SIZE; block * BLOCK_SIZE < end; block++) {
+			if (fabs (scalar_product (direction, (*this)(i, block * BLOCK_SIZE))) + this->radii[i * this->blocksPerRow + block] < min_cos - 1e-9)
+				continue;
+			for (std::size_t j = std::max(begin, block * BLOCK_SIZE); j < std::min(end, (block + 1) * BLOCK_SIZE); j++) {
+				if (fabs (scalar_product (direction, (*this)(i, j))) >= min_cos)
+					visit(j);
+			}
+		}
+	}
+};
+
+// inside() для одного четырёхугольника и хорд chord(p, q); соседние четвёрки
+// делят хорды, поэтому результат для каждой хорды запоминается,
+// пока четырёхугольник не сменится. Таблицы размера n^2 заводятся
+// один раз на поток и переиспользуются для всех четырёхугольников.
+class QuadTest {
+
+private:
+	const Chords &chord;
+	const std::size_t size;
+	std::vector<unsigned> stamps;
+	std::vector<char> values;
+	unsigned stamp;
+	const double *quad[4];
+
+public:
+	QuadTest(const Chords &chord, std::size_t size) : chord(chord), size(size), stamps(size * size, 0), values(size * size, 0), stamp(0), quad{nullptr, nullptr, nullptr, nullptr} {
+	}
+
+	void setQuad(const double *a, const double *b, const double *c, const double *d) {
+		this->stamp++;
+		this->quad[0] = a;
+		this->quad[1] = b;
+		this->quad[2] = c;
+		this->quad[3] = d;
+	}
+
+	int operator()(std::size_t p, std::size_t q) {
+		const std::size_t index = p * this->size + q;
+		if (this->stamps[index] != this->stamp) {
+			this->stamps[index] = this->stamp;
+			this->values[index] = inside(this->quad[0], this->quad[1], this->quad[2], this->quad[3], this->chord(p, q));
+		}
+		return this->values[index];
+	}
+};
+
 /*static int intersected (const double *a, const double *b, const double *c, const double *d) {
 	if (det(a, b, c) * det(a, b, d) > 0)
 		return 0;
@@ -51,113 +168,87 @@ bool inside(const double *a, const double *b, const double *c, const double *d,
 
 }
 
-double Singular::compute(const Knot::Snapshot &snapshot) {
-	double value = 0.0;
+Singular::Singular(const KnotWrapper &knot) : Computable(knot, "Singular") {
+}
 
-	std::size_t i1, i2, i3, i4;
+// Хорды хранятся одним массивом. Из восьми проверок inside() для четвёрки
+// (i1, i2, i3, i4) первые четыре считаются при фиксированной паре (i1, i3),
+// остальные -- при фиксированной паре (i2, i4), с запоминанием по хордам.
+// Внешние циклы раздаются потокам по одной итерации.
+double Singular::compute(const Knot::Snapshot &snapshot, ComputationToken &token) {
+	const std::size_t size = snapshot.size();
+	if (size < 4) {
+		return 0.0;
+	}
 
 	// Вычисляем заранее хорды.
-	double chord_len;
-	double ***chord = new double**[snapshot.size()];
-
-	for (i1 = 0; i1 < snapshot.size(); i1++) {
-		chord[i1] = new double*[snapshot.size()];
-		for (i2 = 0; i2 < snapshot.size(); i2++)
-			chord[i1][i2] = new double[3];
-
-		for (i2 = 0; i2 < i1; i2++) {
-			chord[i1][i2][0] = snapshot[i1].x - snapshot[i2].x;
-			chord[i1][i2][1] = snapshot[i1].y - snapshot[i2].y;
-			chord[i1][i2][2] = snapshot[i1].z - snapshot[i2].z;
-			chord_len = sqrt (vector_square (chord[i1][i2]));
-			chord[i1][i2][0] /= chord_len;
-			chord[i1][i2][1] /= chord_len;
-			chord[i1][i2][2] /= chord_len;
-			chord[i2][i1][0] = - chord[i1][i2][0];
-			chord[i2][i1][1] = - chord[i1][i2][1];
-			chord[i2][i1][2] = - chord[i1][i2][2];
-		}
-	}
+	const Chords chord(snapshot);
 
 	double curr_cos, min_cos = 1.0;
-	for (i1 = 0; i1 < snapshot.size(); i1++)
-		for (i2 = snapshot.next(i1); i2 != snapshot.prev(i1); i2 = snapshot.next(i2)) {
-			curr_cos = fabs (scalar_product (chord[i1][i2], chord[i1][snapshot.next(i2)]));
+	for (std::size_t i1 = 0; i1 < size; i1++)
+		for (std::size_t i2 = snapshot.next(i1); i2 != snapshot.prev(i1); i2 = snapshot.next(i2)) {
+			curr_cos = fabs (scalar_product (chord(i1, i2), chord(i1, snapshot.next(i2))));
 			if (min_cos > curr_cos)
 				min_cos = curr_cos;
 		}
 	min_cos = 4 * min_cos - 3;
 
-	for (i1 = 0; i1 < snapshot.size() - 3; i1++)
-		for (i2 = i1 + 1; i2 < snapshot.size() - 2; i2++)
-			for (i3 = i2 + 1; i3 < snapshot.size() - 1; i3++)
-				for (i4 = i3 + 1; i4 < snapshot.size(); i4++) {
-		if (fabs (scalar_product (chord[i1][i3], chord[i2][i4])) < min_cos)
-			continue;
-//					value += 1;
-//		if (intersected (chord[i1][i3],
-//										 chord[i1][snapshot.next(i3)],
-//										 chord[i2][i4],
-//				 chord[i2][snapshot.next(i4)])
-//						value += 1;
-		if (inside (chord[i1][i3],
-								chord[i1][snapshot.next(i3)],
-								chord[snapshot.next(i1)][snapshot.next(i3)],
-					chord[snapshot.next(i1)][i3],
-								chord[i2][i4]))
-						value += 1;
-		if (inside (chord[i1][i3],
-								chord[i1][snapshot.next(i3)],
-								chord[snapshot.next(i1)][snapshot.next(i3)],
-					chord[snapshot.next(i1)][i3],
-								chord[i2][snapshot.next(i4)]))
-						value += 1;
-		if (inside (chord[i1][i3],
-								chord[i1][snapshot.next(i3)],
-								chord[snapshot.next(i1)][snapshot.next(i3)],
-					chord[snapshot.next(i1)][i3],
-								chord[snapshot.next(i2)][i4]))
-						value += 1;
-		if (inside (chord[i1][i3],
-								chord[i1][snapshot.next(i3)],
-								chord[snapshot.next(i1)][snapshot.next(i3)],
-					chord[snapshot.next(i1)][i3],
-								chord[snapshot.next(i2)][snapshot.next(i4)]))
-						value += 1;
-		if (inside (chord[i2][i4],
-								chord[i2][snapshot.next(i4)],
-								chord[snapshot.next(i2)][snapshot.next(i4)],
-					chord[snapshot.next(i2)][i4],
-								chord[i1][i3]))
-						value += 1;
-		if (inside (chord[i2][i4],
-								chord[i2][snapshot.next(i4)],
-								chord[snapshot.next(i2)][snapshot.next(i4)],
-					chord[snapshot.next(i2)][i4],
-								chord[i1][snapshot.next(i3)]))
-						value += 1;
-		if (inside (chord[i2][i4],
-								chord[i2][snapshot.next(i4)],
-								chord[snapshot.next(i2)][snapshot.next(i4)],
-					chord[snapshot.next(i2)][i4],
-								chord[snapshot.next(i1)][i3]))
-						value += 1;
-		if (inside (chord[i2][i4],
-								chord[i2][snapshot.next(i4)],
-								chord[snapshot.next(i2)][snapshot.next(i4)],
-					chord[snapshot.next(i2)][i4],
-								chord[snapshot.next(i1)][snapshot.next(i3)]))
-						value += 1;
-				}
+	auto &pool = Util::ThreadPool::shared();
+	const std::size_t numberOfWorkers = std::min(pool.size(), size - 3);
+	std::vector<QuadTest> tests(numberOfWorkers, QuadTest(chord, size));
+	// Вызывает body(test, index) для index из [0, size - 3); каждая задача
+	// пула берёт следующий индекс, пока они не кончатся.
+	const auto forEachIndex = [&](const auto &body) {
+		std::atomic<std::size_t> next(0);
+		pool.run(numberOfWorkers, [&](std::size_t worker) {
+			for (std::size_t index = next++; index < size - 3 && !token.isCancelled(); index = next++) {
+				body(tests[worker], index);
+				token.advance();
+			}
+		});
+	};
+
+	// Четвёрки i1 < i2 < i3 < i4 с |(chord(i1, i3), chord(i2, i4))| >= min_cos.
+	std::vector<std::size_t> counts(2 * size, 0);
+	token.start(2 * (size - 3));
+	forEachIndex([&](QuadTest &test, std::size_t i1) {
+		std::size_t count = 0;
+		const std::size_t n1 = snapshot.next(i1);
+		for (std::size_t i3 = i1 + 2; i3 < size - 1; i3++) {
+			const std::size_t n3 = snapshot.next(i3);
+			test.setQuad(chord(i1, i3), chord(i1, n3), chord(n1, n3), chord(n1, i3));
+			for (std::size_t i2 = i1 + 1; i2 < i3; i2++) {
+				const std::size_t n2 = snapshot.next(i2);
+				chord.forParallel(i2, i3 + 1, size, chord(i1, i3), min_cos, [&](std::size_t i4) {
+					const std::size_t n4 = snapshot.next(i4);
+					count += test(i2, i4) + test(i2, n4) + test(n2, i4) + test(n2, n4);
+				});
+			}
+		}
+		counts[i1] = count;
+	});
+	forEachIndex([&](QuadTest &test, std::size_t index) {
+		const std::size_t i2 = index + 1;
+		std::size_t count = 0;
+		const std::size_t n2 = snapshot.next(i2);
+		for (std::size_t i4 = i2 + 2; i4 < size; i4++) {
+			const std::size_t n4 = snapshot.next(i4);
+			test.setQuad(chord(i2, i4), chord(i2, n4), chord(n2, n4), chord(n2, i4));
+			for (std::size_t i1 = 0; i1 < i2; i1++) {
+				const std::size_t n1 = snapshot.next(i1);
+				chord.forParallel(i1, i2 + 1, i4, chord(i2, i4), min_cos, [&](std::size_t i3) {
+					const std::size_t n3 = snapshot.next(i3);
+					count += test(i1, i3) + test(i1, n3) + test(n1, i3) + test(n1, n3);
+				});
+			}
+		}
+		counts[size + i2] = count;
+	});
 
-	// Удаляем заранее вычисленные вспомогательные значения.
-	for (i1 = 0; i1 < snapshot.size(); i1++) {
-		for (i2 = 0; i2 < snapshot.size(); i2++)
-			delete[] chord[i1][i2];
-		delete[] chord[i1];
+	double value = 0.0;
+	for (std::size_t count : counts) {
+		value += count;
 	}
-	delete[] chord;
-
 	return value;
 }
 
@@ -15,70 +15,102 @@
  */
 
 #include "computables.h"
+#include "GaussMatrix.h"
 #include "../ke/KnotWrapper.h"
 
 namespace KE::ThreeD::Math {
 
 VassilievInvariant::VassilievInvariant(const KnotWrapper &knot, int order) :
+	VassilievInvariant(knot, std::make_shared<VassilievInvariants>(order, order), order) {
+}
+
+VassilievInvariant::VassilievInvariant(const KnotWrapper &knot, const std::shared_ptr<VassilievInvariants> &series, int order) :
 	Computable(knot, "Order " + std::to_string(order) + " Vassiliev invariant"),
-	order(order) {
+	order(order),
+	series(series) {
 }
 
-double VassilievInvariant::compute(const Knot::Snapshot &snapshot) {
-	double value = 0.0;
+double VassilievInvariant::compute(const Knot::Snapshot &snapshot, ComputationToken &token) {
+	return this->series->values(snapshot, token)[this->order - this->series->minOrder];
+}
 
-	// tangent vectors
-	std::vector<Vector> tangents;
-	for (std::size_t i = 0; i < snapshot.size(); ++i) {
-		tangents.push_back(Vector(snapshot[i], snapshot[snapshot.next(i)]));
-	}
+VassilievInvariants::VassilievInvariants(int minOrder, int maxOrder) : minOrder(minOrder), maxOrder(maxOrder), key(Knot::Snapshot::newKey()) {
+}
 
-	// Вычисляем ``гауссовы произведения''.
-	std::vector<std::vector<double>> gauss(snapshot.size());
-	for (auto &v : gauss) {
-		v.insert(v.end(), snapshot.size(), 0.0);
-	}
-	for (std::size_t i = 0; i < snapshot.size(); ++i) {
-		for (std::size_t j = 0; j < i; j++) {
-			const Vector chord(
-				(snapshot[i].x + snapshot[snapshot.next(i)].x - snapshot[j].x - snapshot[snapshot.next(j)].x) / 2,
-				(snapshot[i].y + snapshot[snapshot.next(i)].y - snapshot[j].y - snapshot[snapshot.next(j)].y) / 2,
-				(snapshot[i].z + snapshot[snapshot.next(i)].z - snapshot[j].z - snapshot[snapshot.next(j)].z) / 2
-			);
-			double chord_len = chord.length();
-			gauss[i][j] = tangents[i].scalar_product(tangents[j].vector_product(chord)) / (chord_len * chord_len * chord_len);
-			gauss[j][i] = gauss[i][j];
-		}
+// Значения хранятся в кэше снимка; прерванное вычисление не сохраняется,
+// и тогда возвращаются нули.
+std::vector<double> VassilievInvariants::values(const Knot::Snapshot &snapshot, ComputationToken &token) {
+	const auto values = snapshot.cachedValue(this->key, 0, [this, &snapshot, &token]() -> std::shared_ptr<const void> {
+		auto values = std::make_shared<const std::vector<double>>(compute(snapshot, this->minOrder, this->maxOrder, token));
+		return token.isCancelled() ? nullptr : values;
+	});
+	if (!values) {
+		return std::vector<double>(this->maxOrder - this->minOrder + 1, 0.0);
 	}
+	return *std::static_pointer_cast<const std::vector<double>>(values);
+}
 
-	// Вычисляем суммы ``гауссовых произведений''.
+// В gauss_sum[i1][i2] находится сумма ``гауссовых произведений''
+// для всех хорд с началом в i1 и концом от snapshot.next(i1) до i2.
+// Вместо матрицы n x n храним только столбцы gauss_sum[*][prev(i)]
+// и gauss_sum[*][i] и диагональ gauss_sum[j][prev(prev(j))]; строки
+// матрицы ``гауссовых произведений'' перебираются по порядку.
+// Порядок сложений тот же, что и с полными матрицами.
+std::vector<double> VassilievInvariants::compute(const Knot::Snapshot &snapshot, int minOrder, int maxOrder, ComputationToken &token) {
+	std::vector<double> values(maxOrder - minOrder + 1, 0.0);
 
-	// В gauss_sum[i1][i2] находится сумма ``гауссовых произведений''
-	// для всех хорд с началом в i1 и концом от snapshot.next(i1) до i2.
-	std::vector<std::vector<double>> gauss_sum(snapshot.size());
-	for (auto &v : gauss_sum) {
-		v.insert(v.end(), snapshot.size(), 0.0);
-	}
-	for (std::size_t i = 0; i < snapshot.size(); i++) {
+	const std::size_t size = snapshot.size();
+	GaussRows gauss(snapshot, token);
+
+	// previous[j] = gauss_sum[j][size - 1], diagonal[j] = gauss_sum[j][prev(prev(j))]
+	std::vector<double> previous(size, 0.0), current(size), diagonal(size, 0.0);
+	token.start(2 * size);
+	for (std::size_t i = 0; i < size; i++, token.advance()) {
+		if (token.isCancelled()) {
+			return values;
+		}
+		const double *row = gauss.row(i);
+		double sum = 0.0;
 		for (std::size_t j = snapshot.next(i); j != i; j = snapshot.next(j)) {
-			gauss_sum[i][j] = gauss_sum[i][snapshot.prev(j)] + gauss[i][j];
+			sum += row[j];
+			if (j == size - 1) {
+				previous[i] = sum;
+			}
+			if (j == snapshot.prev(snapshot.prev(i))) {
+				diagonal[i] = sum;
+			}
 		}
 	}
 
-	for (std::size_t i = 0; i < snapshot.size(); i++) {
+	for (std::size_t i = 0; i < size; i++, token.advance()) {
+		if (token.isCancelled()) {
+			return values;
+		}
+		const double *row = gauss.row(i);
+		for (std::size_t j = 0; j < size; j++) {
+			current[j] = j == i ? 0.0 : previous[j] + row[j];
+		}
+
 		double tmp = 0.0;
 		for (std::size_t j = snapshot.next(snapshot.next(i)); j != i; j = snapshot.next(j)) {
-			tmp += gauss_sum[snapshot.prev(j)][snapshot.prev(i)] -
-						 gauss_sum[j][snapshot.prev(snapshot.prev(j))] + gauss_sum[j][i];
-			double tmp2 = gauss[i][j];
-			for (int o = 1; o < order; o++) {
+			tmp += previous[snapshot.prev(j)] - diagonal[j] + current[j];
+			// Слагаемые всех порядков: gauss * (tmp / 16)^(order - 1).
+			double tmp2 = row[j];
+			for (int o = 1; o < maxOrder; o++) {
+				if (o >= minOrder) {
+					values[o - minOrder] += tmp2;
+				}
 				tmp2 *= tmp / 16;
 			}
-			value += tmp2;
+			values[maxOrder - minOrder] += tmp2;
 		}
+		previous.swap(current);
 	}
 
-	return value / (4 * M_PI * M_PI);
+	for (auto &value : values) {
+		value /= 4 * M_PI * M_PI;
+	}
+	return values;
 }
 
 }
@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 1995-2021, Nikolay Pultsin <geometer@geometer.name>
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "computables.h"
+#include "GaussMatrix.h"
+#include "../ke/KnotWrapper.h"
+
+namespace KE::ThreeD::Math {
+
+Writhe::Writhe(const KnotWrapper &knot) : Computable(knot, "Writhe") {
+}
+
+double Writhe::compute(const Knot::Snapshot &snapshot, ComputationToken &token) {
+	const auto integrals = SegmentGaussIntegrals::cached(snapshot, token);
+	return integrals ? integrals->writhe : 0.0;
+}
+
+ExactAverageCrossingNumber::ExactAverageCrossingNumber(const KnotWrapper &knot) : Computable(knot, "Average crossing number (exact)") {
+}
+
+double ExactAverageCrossingNumber::compute(const Knot::Snapshot &snapshot, ComputationToken &token) {
+	const auto integrals = SegmentGaussIntegrals::cached(snapshot, token);
+	return integrals ? integrals->averageCrossingNumber : 0.0;
+}
+
+}
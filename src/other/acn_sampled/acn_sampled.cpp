@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 1995-2021, Nikolay Pultsin <geometer@geometer.name>
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cstdlib>
+#include <iostream>
+#include <fstream>
+
+#include <rapidjson/document.h>
+#include <rapidjson/istreamwrapper.h>
+
+#include "../../ke/KnotWrapper.h"
+#include "../../math/computables.h"
+
+int main(int argc, const char **argv) {
+	if (argc < 2 || argc > 3) {
+		std::cerr << "Usage:\n\t" << argv[0] << " <file.knt> [<relative precision, default 0.05>]\n";
+		return 1;
+	}
+
+	rapidjson::Document doc;
+	std::ifstream is(argv[1]);
+	rapidjson::IStreamWrapper wrapper(is);
+	doc.ParseStream(wrapper);
+	is.close();
+	KE::ThreeD::KnotWrapper knot(doc);
+	KE::ThreeD::Math::SampledCrossingNumber acn(knot, argc == 3 ? std::atof(argv[2]) : 0.05);
+	const auto estimate = acn.estimate();
+	std::cout << acn.name << ": " << estimate->mean << " ± " << estimate->halfWidth
+		<< " (" << estimate->numberOfSamples << " directions)\n";
+	const auto &direction = estimate->minDirection;
+	std::cout << "Fewest crossings: " << estimate->minCrossings
+		<< " along (" << direction.x << ", " << direction.y << ", " << direction.z << ")\n";
+
+	return 0;
+}
@@ -0,0 +1,3 @@
+include (../commandline.pri)
+
+TARGET = acn_sampled
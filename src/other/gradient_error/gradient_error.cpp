@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 1995-2021, Nikolay Pultsin <geometer@geometer.name>
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+#include <rapidjson/document.h>
+#include <rapidjson/istreamwrapper.h>
+
+#include "../../ke/EnergyKernel.h"
+#include "../../ke/Knot.h"
+#include "../../ke/ThreadPool.h"
+
+using namespace KE::ThreeD;
+
+namespace {
+
+void print_usage(const std::string &argv0) {
+	std::cerr << "Usage:\n\t" << argv0 << " <opening angle> <number of points> <file.knt> ...\n";
+}
+
+double gradient(EnergyKernel::Method method, double openingAngle, const PointArray &points, std::vector<Vector> &delta) {
+	EnergyKernel kernel;
+	kernel.setMethod(method, openingAngle);
+	const auto start = std::chrono::steady_clock::now();
+	kernel.gradient(points, delta, KE::Util::ThreadPool::shared());
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+int main(int argc, const char **argv) {
+	if (argc < 4) {
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	const double openingAngle = std::stod(argv[1]);
+	const std::size_t numberOfPoints = std::stoi(argv[2]);
+	if (openingAngle <= 0 || numberOfPoints < 10) {
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	double maxError = 0.0;
+	double totalError = 0.0;
+	for (int index = 3; index < argc; ++index) {
+		rapidjson::Document doc;
+		std::ifstream is(argv[index]);
+		rapidjson::IStreamWrapper wrapper(is);
+		doc.ParseStream(wrapper);
+		is.close();
+
+		Knot knot(doc);
+		knot.normalize(numberOfPoints);
+		knot.center();
+		const auto snapshot = knot.snapshot();
+
+		std::vector<Vector> exact, approximate;
+		const double exactTime = gradient(EnergyKernel::Method::exact, openingAngle, snapshot.points(), exact);
+		const double approximateTime = gradient(EnergyKernel::Method::farField, openingAngle, snapshot.points(), approximate);
+
+		double norm = 0.0;
+		double diff = 0.0;
+		for (std::size_t i = 0; i < exact.size(); ++i) {
+			norm += exact[i].square();
+			diff += Vector::linear(exact[i], 1.0, approximate[i], -1.0).square();
+		}
+		const double error = sqrt(diff / norm);
+		maxError = std::max(maxError, error);
+		totalError += error;
+
+		std::cout << argv[index]
+			<< ": relative error " << error
+			<< ", exact " << exactTime * 1000 << " ms"
+			<< ", far field " << approximateTime * 1000 << " ms\n";
+	}
+	std::cout << "mean relative error " << totalError / (argc - 3) << ", max " << maxError << "\n";
+
+	return 0;
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 1995-2021, Nikolay Pultsin <geometer@geometer.name>
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+#include <rapidjson/document.h>
+#include <rapidjson/istreamwrapper.h>
+
+#include "../../ke/Knot.h"
+#include "../../ke/ThreadPool.h"
+
+using namespace KE::ThreeD;
+
+namespace {
+
+void print_usage(const std::string &argv0) {
+	std::cerr << "Usage:\n\t" << argv0 << " <file.knt> [<number of iterations>]\n";
+}
+
+double energy(const Knot &knot) {
+	EnergyKernel kernel;
+	return kernel.energy(knot.snapshot().points(), KE::Util::ThreadPool::shared());
+}
+
+// Sizes around the level boundaries of the default cascade (coarsest
+// level 256 points, 4 times more points on each next level): no coarse
+// levels below 1024 points, one up to 4095, two from 4096.
+const std::size_t SIZES[] = {300, 511, 512, 600, 1023, 1024, 1500, 4096};
+
+}
+
+int main(int argc, const char **argv) {
+	if (argc < 2 || argc > 3) {
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	const std::size_t numberOfIterations = argc > 2 ? std::stoi(argv[2]) : 3;
+	if (numberOfIterations < 1) {
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	rapidjson::Document doc;
+	std::ifstream is(argv[1]);
+	rapidjson::IStreamWrapper wrapper(is);
+	doc.ParseStream(wrapper);
+	is.close();
+
+	bool passed = true;
+	for (const std::size_t numberOfPoints : SIZES) {
+		Knot knot(doc);
+		knot.normalize(numberOfPoints);
+		knot.center();
+		knot.setOptimizer(Optimizer::create(Optimizer::Method::multigrid));
+		const double initial = energy(knot);
+		for (std::size_t i = 0; i < numberOfIterations; ++i) {
+			knot.decreaseEnergy();
+		}
+		const std::size_t size = knot.snapshot().points().size();
+		const double final = energy(knot);
+
+		const bool ok = size == numberOfPoints && std::isfinite(final) && final <= initial;
+		std::cout << numberOfPoints << " points: energy " << initial << " -> " << final
+			<< ", " << size << " points after " << numberOfIterations << " iterations"
+			<< (ok ? "" : ", FAILED") << "\n";
+		passed = passed && ok;
+	}
+
+	return passed ? 0 : 2;
+}
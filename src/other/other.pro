@@ -1,3 +1,3 @@
 TEMPLATE = subdirs
 
-SUBDIRS = vassiliev converter torus dtcode alexander_polynomial
+SUBDIRS = vassiliev converter torus dtcode alexander_polynomial smoothing_benchmark gradient_error smoothing_steps smoothing_allocations multigrid_levels smooth acn_sampled
@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) 1995-2021, Nikolay Pultsin <geometer@geometer.name>
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include <rapidjson/document.h>
+#include <rapidjson/istreamwrapper.h>
+#include <rapidjson/ostreamwrapper.h>
+#include <rapidjson/writer.h>
+
+#include "../../ke/ConvergenceMonitor.h"
+#include "../../ke/Knot.h"
+
+using namespace KE::ThreeD;
+
+namespace {
+
+struct Options {
+	std::size_t numberOfPoints = 0;
+	std::size_t maxIterations = 10000;
+	double maxSeconds = 0.0;
+	double checkpointSeconds = 60.0;
+	std::size_t numberOfWorkers = std::max(1u, std::thread::hardware_concurrency());
+	Optimizer::Method method = Optimizer::Method::lbfgs;
+	bool stopOnConvergence = true;
+	std::vector<std::string> files;
+};
+
+std::atomic<bool> interrupted(false);
+std::mutex outputMutex;
+
+void print_usage(const std::string &argv0) {
+	std::cerr << "Usage:\n\t" << argv0 << " [options] <file.knt>...\n"
+		<< "Options:\n"
+		<< "\t--points <n>          resample each knot to n points before smoothing\n"
+		<< "\t--iterations <n>      iterations per knot (default 10000)\n"
+		<< "\t--time <seconds>      time per knot (default unlimited)\n"
+		<< "\t--checkpoint <seconds> interval between checkpoints (default 60)\n"
+		<< "\t--jobs <n>            number of knots smoothed at once (default: number of cores)\n"
+		<< "\t--method <name>       gradient, line-search, lbfgs (default), sobolev or multigrid\n"
+		<< "\t--no-convergence      do not stop when the smoothing converges\n"
+		<< "For <file>.knt, the result is written to <file>.smooth.knt. While a knot\n"
+		<< "is smoothed, its state is saved to <file>.smooth.checkpoint; a next run\n"
+		<< "resumes from that file. Knots with a result and no checkpoint are skipped.\n";
+}
+
+bool parseOptions(int argc, const char **argv, Options &options) {
+	static const std::map<std::string, Optimizer::Method> methods = {
+		{"gradient", Optimizer::Method::gradientDescent},
+		{"line-search", Optimizer::Method::lineSearch},
+		{"lbfgs", Optimizer::Method::lbfgs},
+		{"sobolev", Optimizer::Method::sobolev},
+		{"multigrid", Optimizer::Method::multigrid},
+	};
+
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		if (arg.rfind("--", 0) != 0) {
+			options.files.push_back(arg);
+			continue;
+		}
+		if (arg == "--no-convergence") {
+			options.stopOnConvergence = false;
+			continue;
+		}
+		if (i + 1 == argc) {
+			return false;
+		}
+		const std::string value = argv[++i];
+		if (arg == "--points") {
+			options.numberOfPoints = std::stoul(value);
+		} else if (arg == "--iterations") {
+			options.maxIterations = std::stoul(value);
+		} else if (arg == "--time") {
+			options.maxSeconds = std::stod(value);
+		} else if (arg == "--checkpoint") {
+			options.checkpointSeconds = std::stod(value);
+		} else if (arg == "--jobs") {
+			options.numberOfWorkers = std::max(std::stoul(value), 1ul);
+		} else if (arg == "--method" && methods.find(value) != methods.end()) {
+			options.method = methods.at(value);
+		} else {
+			return false;
+		}
+	}
+	return !options.files.empty() && (options.numberOfPoints == 0 || options.numberOfPoints >= 10);
+}
+
+std::string baseName(const std::string &fileName) {
+	const std::string extension = ".knt";
+	if (fileName.size() > extension.size() && fileName.compare(fileName.size() - extension.size(), extension.size(), extension) == 0) {
+		return fileName.substr(0, fileName.size() - extension.size());
+	}
+	return fileName;
+}
+
+bool exists(const std::string &fileName) {
+	return std::ifstream(fileName).good();
+}
+
+rapidjson::Document read(const std::string &fileName) {
+	rapidjson::Document doc;
+	std::ifstream is(fileName);
+	rapidjson::IStreamWrapper wrapper(is);
+	doc.ParseStream(wrapper);
+	return doc;
+}
+
+// Пишем во временный файл и переименовываем его, чтобы прерванная
+// запись не испортила предыдущую контрольную точку.
+void write(rapidjson::Document &doc, const std::string &fileName) {
+	const std::string temporary = fileName + ".tmp";
+	{
+		std::ofstream os(temporary);
+		rapidjson::OStreamWrapper wrapper(os);
+		rapidjson::Writer<rapidjson::OStreamWrapper> writer(wrapper);
+		doc.Accept(writer);
+	}
+	if (std::rename(temporary.c_str(), fileName.c_str()) != 0) {
+		throw std::runtime_error("Cannot write " + fileName);
+	}
+}
+
+// The checkpoint is a regular knot file with the progress
+// in the additional "smoothing" member.
+void writeCheckpoint(Knot &knot, std::size_t iterations, double seconds, const std::string &fileName) {
+	knot.publish();
+	auto doc = knot.serialize();
+	rapidjson::Value progress(rapidjson::kObjectType);
+	progress.AddMember("iterations", (uint64_t)iterations, doc.GetAllocator());
+	progress.AddMember("seconds", seconds, doc.GetAllocator());
+	doc.AddMember("smoothing", progress, doc.GetAllocator());
+	write(doc, fileName);
+}
+
+void report(const std::string &fileName, const std::string &message) {
+	std::lock_guard<std::mutex> guard(outputMutex);
+	std::cout << fileName << ": " << message << std::endl;
+}
+
+void smooth(const std::string &fileName, const Options &options) {
+	const std::string name = baseName(fileName);
+	const std::string outputName = name + ".smooth.knt";
+	const std::string checkpointName = name + ".smooth.checkpoint";
+
+	std::size_t iterations = 0;
+	double seconds = 0.0;
+	std::unique_ptr<Knot> knot;
+	if (exists(checkpointName)) {
+		const auto doc = read(checkpointName);
+		knot = std::make_unique<Knot>(doc);
+		if (doc.HasMember("smoothing") && doc["smoothing"].IsObject()) {
+			const auto &progress = doc["smoothing"];
+			if (progress.HasMember("iterations") && progress["iterations"].IsUint64()) {
+				iterations = progress["iterations"].GetUint64();
+			}
+			if (progress.HasMember("seconds") && progress["seconds"].IsNumber()) {
+				seconds = progress["seconds"].GetDouble();
+			}
+		}
+		report(fileName, "resumed after " + std::to_string(iterations) + " iterations");
+	} else if (exists(outputName)) {
+		report(fileName, "skipped, " + outputName + " exists");
+		return;
+	} else {
+		knot = std::make_unique<Knot>(read(fileName));
+		if (options.numberOfPoints > 0) {
+			knot->normalize(options.numberOfPoints);
+		}
+		knot->center();
+	}
+	// Один узел на поток: параллелизм даёт число одновременно сглаживаемых узлов.
+	knot->setNumberOfThreads(1);
+	knot->setOptimizer(Optimizer::create(options.method));
+
+	auto reason = ConvergenceMonitor::Reason::none;
+	auto start = std::chrono::steady_clock::now();
+	const double startSeconds = seconds;
+	double checkpointSeconds = seconds;
+	while (iterations < options.maxIterations && !interrupted) {
+		knot->decreaseEnergy(false);
+		++iterations;
+		seconds = startSeconds + std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		if (options.stopOnConvergence) {
+			reason = knot->convergence();
+			if (reason != ConvergenceMonitor::Reason::none) {
+				break;
+			}
+		}
+		if (options.maxSeconds > 0.0 && seconds >= options.maxSeconds) {
+			break;
+		}
+		if (seconds - checkpointSeconds >= options.checkpointSeconds) {
+			writeCheckpoint(*knot, iterations, seconds, checkpointName);
+			checkpointSeconds = seconds;
+		}
+	}
+
+	if (interrupted) {
+		writeCheckpoint(*knot, iterations, seconds, checkpointName);
+		report(fileName, "interrupted after " + std::to_string(iterations) + " iterations; checkpoint saved");
+		return;
+	}
+
+	knot->publish();
+	auto doc = knot->serialize();
+	write(doc, outputName);
+	std::remove(checkpointName.c_str());
+	report(fileName, std::to_string(iterations) + " iterations, " + std::to_string(seconds) + " s" + (
+		reason != ConvergenceMonitor::Reason::none ? std::string(", converged: ") + ConvergenceMonitor::description(reason) : std::string()
+	));
+}
+
+}
+
+int main(int argc, const char **argv) {
+	Options options;
+	try {
+		if (!parseOptions(argc, argv, options)) {
+			print_usage(argv[0]);
+			return 1;
+		}
+	} catch (const std::exception &e) {
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	// По Ctrl-C каждый узел сохраняет контрольную точку.
+	std::signal(SIGINT, [](int) { interrupted = true; });
+	std::signal(SIGTERM, [](int) { interrupted = true; });
+
+	std::atomic<std::size_t> next(0);
+	std::atomic<bool> failed(false);
+	std::vector<std::thread> workers;
+	for (std::size_t i = 0; i < std::min(options.numberOfWorkers, options.files.size()); ++i) {
+		workers.emplace_back([&] {
+			for (std::size_t index = next++; index < options.files.size() && !interrupted; index = next++) {
+				try {
+					smooth(options.files[index], options);
+				} catch (const std::exception &e) {
+					report(options.files[index], std::string("error: ") + e.what());
+					failed = true;
+				}
+			}
+		});
+	}
+	for (auto &worker : workers) {
+		worker.join();
+	}
+
+	return interrupted || failed ? 2 : 0;
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 1995-2021, Nikolay Pultsin <geometer@geometer.name>
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+
+#include <rapidjson/document.h>
+#include <rapidjson/istreamwrapper.h>
+
+#include "../../ke/Knot.h"
+
+// Every heap allocation in the process, including the thread pool workers,
+// goes through these operators and is counted.
+namespace {
+
+std::atomic<std::size_t> numberOfAllocations(0);
+
+void *allocate(std::size_t size, std::size_t alignment) {
+	numberOfAllocations += 1;
+	void *memory = alignment > 0
+		? std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)
+		: std::malloc(size ? size : 1);
+	if (!memory) {
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+}
+
+void *operator new(std::size_t size) { return allocate(size, 0); }
+void *operator new[](std::size_t size) { return allocate(size, 0); }
+void *operator new(std::size_t size, std::align_val_t alignment) { return allocate(size, (std::size_t)alignment); }
+void *operator new[](std::size_t size, std::align_val_t alignment) { return allocate(size, (std::size_t)alignment); }
+void operator delete(void *memory) noexcept { std::free(memory); }
+void operator delete[](void *memory) noexcept { std::free(memory); }
+void operator delete(void *memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void *memory, std::size_t) noexcept { std::free(memory); }
+void operator delete(void *memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void *memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete(void *memory, std::size_t, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void *memory, std::size_t, std::align_val_t) noexcept { std::free(memory); }
+
+using namespace KE::ThreeD;
+
+namespace {
+
+void print_usage(const std::string &argv0) {
+	std::cerr << "Usage:\n\t" << argv0 << " <file.knt> [<number of points> [<number of iterations>]]\n";
+}
+
+// iterations before the count: L-BFGS fills its history, the Sobolev
+// interaction lists grow to their maximal size, and the multigrid cascade
+// (which allocates its coarse polygons) is made on the first iteration
+const std::size_t WARM_UP_ITERATIONS = 100;
+
+}
+
+int main(int argc, const char **argv) {
+	if (argc < 2 || argc > 4) {
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	const std::size_t numberOfPoints = argc > 2 ? std::stoi(argv[2]) : 1000;
+	const std::size_t numberOfIterations = argc > 3 ? std::stoi(argv[3]) : 50;
+	if (numberOfPoints < 10 || numberOfIterations < 1) {
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	rapidjson::Document doc;
+	std::ifstream is(argv[1]);
+	rapidjson::IStreamWrapper wrapper(is);
+	doc.ParseStream(wrapper);
+	is.close();
+
+	const std::pair<Optimizer::Method, std::string> methods[] = {
+		{Optimizer::Method::gradientDescent, "gradient descent"},
+		{Optimizer::Method::lineSearch, "line search"},
+		{Optimizer::Method::lbfgs, "L-BFGS"},
+		{Optimizer::Method::sobolev, "Sobolev"},
+		{Optimizer::Method::multigrid, "multigrid"},
+	};
+	bool allocationFree = true;
+	for (const auto &[method, name] : methods) {
+		Knot knot(doc);
+		knot.normalize(numberOfPoints);
+		knot.center();
+		knot.setOptimizer(Optimizer::create(method));
+		for (std::size_t i = 0; i < WARM_UP_ITERATIONS; ++i) {
+			knot.decreaseEnergy();
+		}
+
+		const std::size_t before = numberOfAllocations;
+		for (std::size_t i = 0; i < numberOfIterations; ++i) {
+			knot.decreaseEnergy();
+		}
+		const std::size_t count = numberOfAllocations - before;
+
+		std::cout << name << ": " << count << " allocations in " << numberOfIterations << " iterations\n";
+		allocationFree = allocationFree && count == 0;
+	}
+
+	return allocationFree ? 0 : 2;
+}
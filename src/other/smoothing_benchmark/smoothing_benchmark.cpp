@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 1995-2021, Nikolay Pultsin <geometer@geometer.name>
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+#include <rapidjson/document.h>
+#include <rapidjson/istreamwrapper.h>
+
+#include "../../ke/Knot.h"
+
+namespace {
+
+void print_usage(const std::string &argv0) {
+	std::cerr << "Usage:\n\t" << argv0 << " <file.knt> [<number of points> [<number of iterations>]]\n";
+}
+
+std::vector<KE::ThreeD::Point> smooth(const rapidjson::Document &doc, std::size_t numberOfPoints, std::size_t numberOfIterations, std::size_t numberOfThreads, double &seconds) {
+	KE::ThreeD::Knot knot(doc);
+	knot.setNumberOfThreads(numberOfThreads);
+	knot.normalize(numberOfPoints);
+	knot.center();
+
+	const auto start = std::chrono::steady_clock::now();
+	for (std::size_t i = 0; i < numberOfIterations; ++i) {
+		knot.decreaseEnergy();
+	}
+	seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	const auto snapshot = knot.snapshot();
+	std::vector<KE::ThreeD::Point> points;
+	for (std::size_t i = 0; i < snapshot.size(); ++i) {
+		points.push_back(snapshot[i]);
+	}
+	return points;
+}
+
+bool identical(const std::vector<KE::ThreeD::Point> &points0, const std::vector<KE::ThreeD::Point> &points1) {
+	if (points0.size() != points1.size()) {
+		return false;
+	}
+	for (std::size_t i = 0; i < points0.size(); ++i) {
+		if (points0[i].x != points1[i].x || points0[i].y != points1[i].y || points0[i].z != points1[i].z) {
+			return false;
+		}
+	}
+	return true;
+}
+
+}
+
+int main(int argc, const char **argv) {
+	if (argc < 2 || argc > 4) {
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	const std::size_t numberOfPoints = argc > 2 ? std::stoi(argv[2]) : 5000;
+	const std::size_t numberOfIterations = argc > 3 ? std::stoi(argv[3]) : 20;
+	if (numberOfPoints < 10 || numberOfIterations < 1) {
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	rapidjson::Document doc;
+	std::ifstream is(argv[1]);
+	rapidjson::IStreamWrapper wrapper(is);
+	doc.ParseStream(wrapper);
+	is.close();
+
+	const std::size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<std::size_t> threadCounts;
+	for (std::size_t count = 1; count < maxThreads; count *= 2) {
+		threadCounts.push_back(count);
+	}
+	threadCounts.push_back(maxThreads);
+
+	std::cout << numberOfPoints << " points, " << numberOfIterations << " iterations\n";
+	std::vector<KE::ThreeD::Point> reference;
+	double referenceSeconds = 0.0;
+	for (const auto count : threadCounts) {
+		double seconds;
+		const auto points = smooth(doc, numberOfPoints, numberOfIterations, count, seconds);
+		if (reference.empty()) {
+			reference = points;
+			referenceSeconds = seconds;
+		}
+		std::cout
+			<< "threads: " << count
+			<< ", iterations per second: " << numberOfIterations / seconds
+			<< ", speedup: " << referenceSeconds / seconds
+			<< (identical(reference, points) ? "" : ", RESULT DIFFERS")
+			<< "\n";
+	}
+
+	return 0;
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 1995-2021, Nikolay Pultsin <geometer@geometer.name>
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+#include <rapidjson/document.h>
+#include <rapidjson/istreamwrapper.h>
+
+#include "../../ke/Knot.h"
+#include "../../ke/ThreadPool.h"
+
+using namespace KE::ThreeD;
+
+namespace {
+
+void print_usage(const std::string &argv0) {
+	std::cerr << "Usage:\n\t" << argv0 << " <file.knt> [<number of points> [<number of iterations>]]\n";
+}
+
+double energy(const Knot &knot) {
+	EnergyKernel kernel;
+	return kernel.energy(knot.snapshot().points(), KE::Util::ThreadPool::shared());
+}
+
+}
+
+int main(int argc, const char **argv) {
+	if (argc < 2 || argc > 4) {
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	const std::size_t numberOfPoints = argc > 2 ? std::stoi(argv[2]) : 1000;
+	const std::size_t numberOfIterations = argc > 3 ? std::stoi(argv[3]) : 200;
+	if (numberOfPoints < 10 || numberOfIterations < 1) {
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	rapidjson::Document doc;
+	std::ifstream is(argv[1]);
+	rapidjson::IStreamWrapper wrapper(is);
+	doc.ParseStream(wrapper);
+	is.close();
+
+	// The fixed heuristic step sets the target energy...
+	Knot heuristic(doc);
+	heuristic.normalize(numberOfPoints);
+	heuristic.center();
+	std::cout << "initial energy: " << energy(heuristic) << "\n";
+	auto start = std::chrono::steady_clock::now();
+	for (std::size_t i = 0; i < numberOfIterations; ++i) {
+		heuristic.decreaseEnergy();
+	}
+	const double heuristicSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	const double target = energy(heuristic);
+	std::cout << "gradient descent: energy " << target << " after " << numberOfIterations << " iterations, " << heuristicSeconds << " s, last step " << heuristic.lastStep().stepSize << "\n";
+
+	// ...that the energy-monitored optimizers have to reach.
+	const std::pair<Optimizer::Method, std::string> methods[] = {
+		{Optimizer::Method::lineSearch, "line search"},
+		{Optimizer::Method::lbfgs, "L-BFGS"},
+		{Optimizer::Method::sobolev, "Sobolev"},
+		{Optimizer::Method::multigrid, "multigrid"},
+	};
+	for (const auto &[method, name] : methods) {
+		Knot knot(doc);
+		knot.normalize(numberOfPoints);
+		knot.center();
+		knot.setOptimizer(Optimizer::create(method));
+		start = std::chrono::steady_clock::now();
+		std::size_t iterations = 0;
+		std::size_t failures = 0;
+		for (; iterations < 10 * numberOfIterations; ++iterations) {
+			knot.decreaseEnergy();
+			const auto step = knot.lastStep();
+			std::cout << name << " iteration " << iterations + 1
+				<< ": step " << step.stepSize
+				<< ", trials " << step.numberOfTrials
+				<< ", energy " << step.energy << "\n";
+			failures = step.stepSize > 0.0 ? 0 : failures + 1;
+			if (step.energy <= target || failures == 3) {
+				++iterations;
+				break;
+			}
+		}
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::cout << name << ": energy " << energy(knot) << " after " << iterations << " iterations, " << seconds << " s\n";
+	}
+
+	return 0;
+}
@@ -0,0 +1,3 @@
+include (../commandline.pri)
+
+TARGET = smoothing_steps
@@ -36,8 +36,9 @@ int main(int argc, const char **argv) {
 	doc.ParseStream(wrapper);
 	is.close();
 	KE::ThreeD::KnotWrapper knot(doc);
-	for (std::size_t order = 1; order < 10; ++order) {
-		KE::ThreeD::Math::VassilievInvariant invariant(knot, order);
+	const auto series = std::make_shared<KE::ThreeD::Math::VassilievInvariants>(1, 9);
+	for (int order = series->minOrder; order <= series->maxOrder; ++order) {
+		KE::ThreeD::Math::VassilievInvariant invariant(knot, series, order);
 		std::cout << invariant.name << ": " << invariant.value() << "\n";
 	}
 
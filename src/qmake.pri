@@ -1,5 +1,7 @@
 QMAKE_CXX = ccache $$QMAKE_CXX
 QMAKE_CXXFLAGS += -Wno-unused-command-line-argument
+# sqrt() without errno checks, so that loops calling it can be vectorized
+QMAKE_CXXFLAGS += -fno-math-errno
 
 CONFIG += c++17
 
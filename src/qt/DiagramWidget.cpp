@@ -154,7 +154,7 @@ void DiagramWidget::drawIt(QPainter &painter) {
 		if (this->capturedCrossing) {
 			this->highlightCrossing(painter, *this->capturedCrossing);
 		}
-		const auto vertices = this->diagram.vertices();
+		const auto &vertices = this->diagram.vertices();
 		auto fakeVertex = this->fakeVertex;
 		if (fakeVertex && !vertices.empty()) {
 			const TwoD::Diagram::Edge edge(fakeVertex, vertices.back());
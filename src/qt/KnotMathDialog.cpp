@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+
 #include <QtCore/QMetaMethod>
 #include <QtWidgets/QCheckBox>
 #include <QtWidgets/QGridLayout>
@@ -22,10 +24,50 @@
 #include "KnotWidget.h"
 #include "KnotWindow.h"
 #include "../math/computables.h"
+#include "../math/evaluator.h"
 #include "../math/experimental.h"
 
 namespace KE::Qt {
 
+namespace {
+
+const int POLLING_INTERVAL = 100;
+// Singular is O(n^4): about 6 s for 300 points, 30 s for 450.
+const std::size_t SINGULAR_MAX_NUMBER_OF_POINTS = 300;
+
+QString pendingText(const QString &lastValue, const ThreeD::Math::Evaluator::Request &request) {
+	const QString state = request.state() == ThreeD::Math::Evaluator::Request::State::running ?
+		QString("computing… %1%").arg((int)(100 * request.progress())) : QString("waiting…");
+	return lastValue.isEmpty() ? state : QString("%1 (stale; %2)").arg(lastValue).arg(state);
+}
+
+}
+
+struct KnotMathDialog::Row {
+	std::shared_ptr<ThreeD::Math::Computable> computable;
+	QCheckBox *checkbox;
+	QLabel *label;
+	// 0 means no limit
+	std::size_t maxNumberOfPoints;
+	std::shared_ptr<ThreeD::Math::Evaluator::Request> request;
+	// cancelled requests that may still be running
+	std::vector<std::shared_ptr<ThreeD::Math::Evaluator::Request>> cancelled;
+	// the last shown value; kept while the new one is being computed
+	QString lastValue;
+
+	// Does not wait for the computation to stop.
+	void cancel() {
+		if (this->request) {
+			ThreeD::Math::Evaluator::shared().cancel(this->request);
+			this->cancelled.push_back(this->request);
+			this->request = nullptr;
+		}
+		this->cancelled.erase(std::remove_if(this->cancelled.begin(), this->cancelled.end(), [](const auto &request) {
+			return !request->isActive();
+		}), this->cancelled.end());
+	}
+};
+
 void KnotWindow::showMathDialog() {
 	if (this->isSignalConnected(QMetaMethod::fromSignal(&KnotWindow::raiseMathDialog))) {
 		emit raiseMathDialog();
@@ -48,48 +90,139 @@ KnotMathDialog::KnotMathDialog(KnotWindow &window) {
 	auto layout = new QGridLayout(this);
 
 	const auto &knot = window.knotWidget()->knot;
+	const auto vassiliev = std::make_shared<ThreeD::Math::VassilievInvariants>(2, 5);
+	const auto singular = std::make_shared<ThreeD::Math::Singular>(knot);
 	std::vector<std::shared_ptr<ThreeD::Math::Computable>> computables = {
 		std::make_shared<ThreeD::Math::MoebiusEnergy>(knot),
+		std::make_shared<ThreeD::Math::MoebiusEnergy>(knot, ThreeD::EnergyKernel::Method::farField),
 		std::make_shared<ThreeD::Math::AverageCrossingNumber>(knot, false),
 		std::make_shared<ThreeD::Math::AverageCrossingNumber>(knot, true),
+		std::make_shared<ThreeD::Math::ExactAverageCrossingNumber>(knot),
+		std::make_shared<ThreeD::Math::SampledCrossingNumber>(knot),
+		std::make_shared<ThreeD::Math::Writhe>(knot),
 		std::make_shared<ThreeD::Math::AverageExtremumNumber>(knot),
-		std::make_shared<ThreeD::Math::VassilievInvariant>(knot, 2),
-		std::make_shared<ThreeD::Math::VassilievInvariant>(knot, 3),
-		std::make_shared<ThreeD::Math::VassilievInvariant>(knot, 4),
-		std::make_shared<ThreeD::Math::VassilievInvariant>(knot, 5),
-		std::make_shared<ThreeD::Math::Experimental>(knot)
-//		std::make_shared<ThreeD::Math::Singular>(knot),
+		std::make_shared<ThreeD::Math::VassilievInvariant>(knot, vassiliev, 2),
+		std::make_shared<ThreeD::Math::VassilievInvariant>(knot, vassiliev, 3),
+		std::make_shared<ThreeD::Math::VassilievInvariant>(knot, vassiliev, 4),
+		std::make_shared<ThreeD::Math::VassilievInvariant>(knot, vassiliev, 5),
+		std::make_shared<ThreeD::Math::Experimental>(knot),
+		singular
 //		std::make_shared<ThreeD::Math::Experimental2>(knot, 2, "Experimental 2"),
 //		std::make_shared<ThreeD::Math::Experimental2>(knot, 3, "Experimental 3"),
 //		std::make_shared<ThreeD::Math::Experimental2>(knot, 4, "Experimental 4"),
 	};
-	for (const auto &computable : computables) {
+	this->rows.resize(computables.size());
+	for (std::size_t i = 0; i < computables.size(); ++i) {
+		Row &row = this->rows[i];
+		row.computable = computables[i];
+		row.maxNumberOfPoints = row.computable == singular ? SINGULAR_MAX_NUMBER_OF_POINTS : 0;
+
 		const int index = layout->rowCount();
-		auto checkbox = new QCheckBox(computable->name.c_str());
-		layout->addWidget(checkbox, index, 0);
-
-		auto value = new QLabel();
-		value->setTextInteractionFlags(::Qt::TextSelectableByMouse);
-		value->setFrameStyle(QFrame::Panel | QFrame::Sunken);
-		value->setMinimumWidth(100);
-		layout->addWidget(value, index, 1);
+		row.checkbox = new QCheckBox(row.computable->name.c_str());
+		layout->addWidget(row.checkbox, index, 0);
+
+		row.label = new QLabel();
+		row.label->setTextInteractionFlags(::Qt::TextSelectableByMouse);
+		row.label->setFrameStyle(QFrame::Panel | QFrame::Sunken);
+		row.label->setMinimumWidth(100);
+		layout->addWidget(row.label, index, 1);
 		layout->setRowMinimumHeight(index, 30);
 
-		const auto callback = [checkbox, value, computable] {
-			if (checkbox->isChecked()) {
-				value->setText(QString::number(computable->value()));
-			} else {
-				value->setText(QString());
-			}
-		};
+		const auto callback = [this, i] { this->update(this->rows[i]); };
 		QObject::connect(&window, &Window::contentChanged, this, callback);
-		QObject::connect(checkbox, &QCheckBox::clicked, this, callback);
+		QObject::connect(row.checkbox, &QCheckBox::clicked, this, callback);
 	}
 
+	this->timer = new QTimer(this);
+	this->timer->setInterval(POLLING_INTERVAL);
+	QObject::connect(this->timer, &QTimer::timeout, this, &KnotMathDialog::updatePending);
+
 	layout->setSizeConstraint(QLayout::SetFixedSize);
 
-	QObject::connect(&window, &Window::closing, this, &QDialog::close);
+	// The computations use the knot, so they are stopped before the window is gone.
+	QObject::connect(&window, &Window::closing, this, [this] {
+		this->cancelAll();
+		this->close();
+	});
 	QObject::connect(&window, &KnotWindow::raiseMathDialog, this, &QDialog::raise);
 }
 
+KnotMathDialog::~KnotMathDialog() {
+	this->cancelAll();
+}
+
+// Единственное место, где ждём остановки вычислений: после закрытия
+// окна узел удаляется. Сначала отменяем все запросы, потом ждём.
+void KnotMathDialog::cancelAll() {
+	for (auto &row : this->rows) {
+		row.cancel();
+	}
+	for (auto &row : this->rows) {
+		for (const auto &request : row.cancelled) {
+			ThreeD::Math::Evaluator::shared().wait(request);
+		}
+		row.cancelled.clear();
+	}
+}
+
+// Значение берётся из кэша, если оно посчитано для текущего состояния узла;
+// иначе вычисление ставится в очередь, а до его окончания показывается
+// прежнее значение с пометкой. Запрос для устаревшего снимка не отменяется:
+// новый делается, когда он закончится. Для слишком большого числа точек
+// величина не считается.
+void KnotMathDialog::update(Row &row) {
+	const bool tooLarge = row.maxNumberOfPoints > 0 && row.computable->currentSnapshot()->size() > row.maxNumberOfPoints;
+	if (!row.checkbox->isChecked() || tooLarge) {
+		row.cancel();
+		row.lastValue = QString();
+		row.label->setText(tooLarge && row.checkbox->isChecked() ?
+			QString("over %1 points").arg((int)row.maxNumberOfPoints) : QString());
+		return;
+	}
+
+	double value;
+	if (row.computable->cachedValue(value)) {
+		row.cancel();
+		row.lastValue = QString::number(value);
+		row.label->setText(row.lastValue);
+		return;
+	}
+
+	if (!row.request || !row.request->isActive()) {
+		row.request = ThreeD::Math::Evaluator::shared().request(row.computable);
+		this->timer->start();
+	}
+	row.label->setText(pendingText(row.lastValue, *row.request));
+}
+
+// Результат, посчитанный для снимка, который устарел во время вычисления,
+// показывается с пометкой, и делается новый запрос.
+void KnotMathDialog::updatePending() {
+	bool active = false;
+	for (auto &row : this->rows) {
+		if (!row.request) {
+			continue;
+		}
+		if (row.request->isActive()) {
+			row.label->setText(pendingText(row.lastValue, *row.request));
+			active = true;
+			continue;
+		}
+		const auto request = row.request;
+		row.request = nullptr;
+		if (request->state() == ThreeD::Math::Evaluator::Request::State::finished) {
+			row.lastValue = QString::number(request->value());
+		}
+		if (request->state() == ThreeD::Math::Evaluator::Request::State::finished && !request->snapshot->isObsolete()) {
+			row.label->setText(row.lastValue);
+		} else {
+			this->update(row);
+			active = active || row.request;
+		}
+	}
+	if (!active) {
+		this->timer->stop();
+	}
+}
+
 }
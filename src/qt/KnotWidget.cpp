@@ -67,6 +67,15 @@ bool KnotWidget::isSmoothingInProgress() const {
 	return this->smoothingThread.isRunning();
 }
 
+ThreeD::Optimizer::Method KnotWidget::smoothingMethod() const {
+	return this->smoothingThread.optimizerMethod();
+}
+
+void KnotWidget::setSmoothingMethod(ThreeD::Optimizer::Method method) {
+	this->smoothingThread.setOptimizerMethod(method);
+	emit actionsUpdated();
+}
+
 void KnotWidget::prepareMatrix(double *matrix, bool inverse) const {
 	for (int i = 0; i < 3; ++i) {
 		for (int j = 0; j < 3; ++j) {
@@ -103,6 +112,14 @@ void KnotWidget::setLength() {
 	}
 }
 
+void KnotWidget::setSmoothingPublicationInterval() {
+	bool ok;
+	const int interval = QInputDialog::getInt(nullptr, "Set value", "Show the smoothed knot every (ms)", this->smoothingThread.publicationInterval(), 10, 1000, 10, &ok);
+	if (ok) {
+		this->smoothingThread.setPublicationInterval(interval);
+	}
+}
+
 void KnotWidget::setNumberOfPoints() {
 	const std::size_t numberOfPoints = QInputDialog::getInt(nullptr, "Set value", "Number of points", this->knot.snapshot().size(), 10, 30000, 10);
 	if (numberOfPoints != this->knot.snapshot().size()) {
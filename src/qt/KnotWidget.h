@@ -17,9 +17,13 @@
 #ifndef __KNOTWIDGET_H__
 #define __KNOTWIDGET_H__
 
+#include <atomic>
+#include <mutex>
+
 #include <QtCore/QThread>
 
 #include "GLWidget.h"
+#include "../ke/ConvergenceMonitor.h"
 #include "../ke/KnotWrapper.h"
 
 namespace KE::GL {
@@ -39,12 +43,33 @@ Q_OBJECT
 
 private:
 	ThreeD::KnotWrapper &knot;
+	ThreeD::Optimizer::Method _optimizerMethod;
+	std::atomic<int> _publicationInterval;
+	mutable std::mutex tolerancesMutex;
+	ThreeD::ConvergenceMonitor::Tolerances _tolerances;
+	std::atomic<bool> _stopOnConvergence;
 
 public:
 	SmoothingThread(KnotWidget *widget);
 
+	ThreeD::Optimizer::Method optimizerMethod() const { return this->_optimizerMethod; }
+	// Can be changed while the thread is running; takes effect from the next iteration.
+	void setOptimizerMethod(ThreeD::Optimizer::Method method);
+	// How often (in milliseconds) the smoothed knot is shown;
+	// the iterations between the publications are not seen by readers.
+	int publicationInterval() const { return this->_publicationInterval; }
+	void setPublicationInterval(int milliseconds) { this->_publicationInterval = milliseconds; }
+	// After convergence, the thread either finishes or makes an iteration
+	// per half a second until the knot is changed.
+	bool stopOnConvergence() const { return this->_stopOnConvergence; }
+	void setStopOnConvergence(bool stop) { this->_stopOnConvergence = stop; }
+	// Takes effect from the next start.
+	ThreeD::ConvergenceMonitor::Tolerances tolerances() const;
+	void setTolerances(const ThreeD::ConvergenceMonitor::Tolerances &tolerances);
+
 signals:
 	void knotChanged();
+	void converged(const QString &reason, int numberOfIterations);
 
 private:
 	void run() override;
@@ -78,14 +103,23 @@ public:
 	void stopSmoothing();
 	void stopSmoothingAndWait();
 	bool isSmoothingInProgress() const;
+	ThreeD::Optimizer::Method smoothingMethod() const;
+	void setSmoothingMethod(ThreeD::Optimizer::Method method);
+	void setSmoothingPublicationInterval(int milliseconds) { this->smoothingThread.setPublicationInterval(milliseconds); }
+	bool stopSmoothingOnConvergence() const { return this->smoothingThread.stopOnConvergence(); }
+	void setStopSmoothingOnConvergence(bool stop) { this->smoothingThread.setStopOnConvergence(stop); }
+	ThreeD::ConvergenceMonitor::Tolerances smoothingTolerances() const { return this->smoothingThread.tolerances(); }
+	void setSmoothingTolerances(const ThreeD::ConvergenceMonitor::Tolerances &tolerances) { this->smoothingThread.setTolerances(tolerances); }
 
 	void setSeifertSurfaceVisibility(bool visible);
 	void moveSeifertBasePoint(double distance);
 
 	void setLength();
 	void setNumberOfPoints();
+	void setSmoothingPublicationInterval();
 
 	void onKnotChanged(bool force);
+	void onSmoothingConverged(const QString &reason, int numberOfIterations);
 
 signals:
 	void setActionTip(const QString &tip);
@@ -14,10 +14,18 @@
  * limitations under the License.
  */
 
+#include <chrono>
+
 #include "KnotWidget.h"
 
 namespace KE::Qt {
 
+namespace {
+
+const unsigned long IDLE_INTERVAL = 500;
+
+}
+
 void KnotWidget::startSmoothing() {
 	if (!this->smoothingThread.isRunning()) {
 		this->smoothingThread.start();
@@ -41,24 +49,74 @@ void KnotWidget::stopSmoothingAndWait() {
 	}
 }
 
-SmoothingThread::SmoothingThread(KnotWidget *widget) : knot(widget->knot) {
+void KnotWidget::onSmoothingConverged(const QString &reason, int numberOfIterations) {
+	emit setActionTip(QString("Smoothing converged after %1 iterations: %2").arg(numberOfIterations).arg(reason));
+	emit actionsUpdated();
+}
+
+SmoothingThread::SmoothingThread(KnotWidget *widget) : knot(widget->knot), _optimizerMethod(ThreeD::Optimizer::Method::gradientDescent), _publicationInterval(40), _tolerances(ThreeD::ConvergenceMonitor().tolerances()), _stopOnConvergence(true) {
 	connect(this, &SmoothingThread::knotChanged, widget, [widget] { widget->onKnotChanged(false); });
+	connect(this, &SmoothingThread::converged, widget, [widget](const QString &reason, int numberOfIterations) {
+		widget->onSmoothingConverged(reason, numberOfIterations);
+	});
 	connect(this, &SmoothingThread::finished, widget, [widget] { widget->onKnotChanged(true); });
 }
 
+void SmoothingThread::setOptimizerMethod(ThreeD::Optimizer::Method method) {
+	if (method != this->_optimizerMethod) {
+		this->_optimizerMethod = method;
+		this->knot.setOptimizer(ThreeD::Optimizer::create(method));
+	}
+}
+
+ThreeD::ConvergenceMonitor::Tolerances SmoothingThread::tolerances() const {
+	std::lock_guard<std::mutex> guard(this->tolerancesMutex);
+	return this->_tolerances;
+}
+
+void SmoothingThread::setTolerances(const ThreeD::ConvergenceMonitor::Tolerances &tolerances) {
+	std::lock_guard<std::mutex> guard(this->tolerancesMutex);
+	this->_tolerances = tolerances;
+}
+
+// Итерации идут без пауз на собственных буферах узла; читателям
+// (поверхностям, вычисляемым величинам) результат публикуется не чаще,
+// чем раз в publicationInterval миллисекунд. Когда монитор сообщает
+// о сходимости, поток завершается или переходит в режим ожидания.
 void SmoothingThread::run() {
 	this->setPriority(LowPriority);
-	while (true) {
-		if (this->isInterruptionRequested()) {
-			this->quit();
-			break;
+	// Монитор начинает заново при каждом запуске: сходимость, найденная
+	// другим методом или до остановки, не должна сразу прерывать поток.
+	this->knot.setConvergenceTolerances(this->tolerances());
+	bool idle = false;
+	auto published = std::chrono::steady_clock::now();
+	while (!this->isInterruptionRequested()) {
+		this->knot.decreaseEnergy(false);
+		const auto reason = this->knot.convergence();
+		if (reason == ThreeD::ConvergenceMonitor::Reason::none) {
+			idle = false;
+		} else if (!idle) {
+			this->knot.publish();
+			emit knotChanged();
+			emit converged(ThreeD::ConvergenceMonitor::description(reason), (int)this->knot.numberOfMonitoredSteps());
+			if (this->_stopOnConvergence) {
+				break;
+			}
+			idle = true;
 		}
-		this->msleep(20);
-		for (int i = 0; i < 20; ++i) {
-			this->knot.decreaseEnergy();
+		if (idle) {
+			this->msleep(IDLE_INTERVAL);
+		}
+
+		const auto now = std::chrono::steady_clock::now();
+		if (now - published >= std::chrono::milliseconds(this->_publicationInterval)) {
+			this->knot.publish();
+			published = now;
+			emit knotChanged();
 		}
-		emit knotChanged();
 	}
+	this->knot.publish();
+	this->quit();
 }
 
 }
@@ -67,6 +67,55 @@ void KnotWindow::initMenu() {
 		knotMenu->addAction("Stop smoothing", [this] { this->knotWidget()->stopSmoothing(); }),
 		[this](QAction &action) { action.setEnabled(this->knotWidget()->isSmoothingInProgress()); }
 	);
+	QMenu *methodMenu = knotMenu->addMenu("Smoothing method");
+	auto addMethodAction = [this, methodMenu](const QString &text, ThreeD::Optimizer::Method method) {
+		QAction *action = methodMenu->addAction(text, [this, method] { this->knotWidget()->setSmoothingMethod(method); });
+		action->setCheckable(true);
+		this->registerAction(action, [this, method](QAction &action) {
+			action.setChecked(this->knotWidget()->smoothingMethod() == method);
+		});
+	};
+	addMethodAction("Gradient descent", ThreeD::Optimizer::Method::gradientDescent);
+	addMethodAction("Gradient descent with line search", ThreeD::Optimizer::Method::lineSearch);
+	addMethodAction("L-BFGS", ThreeD::Optimizer::Method::lbfgs);
+	addMethodAction("Sobolev gradient", ThreeD::Optimizer::Method::sobolev);
+	addMethodAction("Coarse-to-fine L-BFGS", ThreeD::Optimizer::Method::multigrid);
+	QAction *stopOnConvergenceAction = knotMenu->addAction("Stop smoothing on convergence", [this] {
+		this->knotWidget()->setStopSmoothingOnConvergence(!this->knotWidget()->stopSmoothingOnConvergence());
+	});
+	stopOnConvergenceAction->setCheckable(true);
+	this->registerAction(stopOnConvergenceAction, [this](QAction &action) {
+		action.setChecked(this->knotWidget()->stopSmoothingOnConvergence());
+	});
+	// Допуски применяются при следующем запуске сглаживания; ноль
+	// отключает соответствующий критерий.
+	QMenu *tolerancesMenu = knotMenu->addMenu("Convergence tolerances");
+	auto addToleranceAction = [this, tolerancesMenu](const QString &text, double ThreeD::ConvergenceMonitor::Tolerances::*tolerance) {
+		tolerancesMenu->addAction(text, [this, text, tolerance] {
+			auto tolerances = this->knotWidget()->smoothingTolerances();
+			bool ok;
+			const double value = QInputDialog::getDouble(
+				this, "Set value", text.chopped(1) + " (0 disables)", tolerances.*tolerance, 0.0, 1.0, 10, &ok
+			);
+			if (ok) {
+				tolerances.*tolerance = value;
+				this->knotWidget()->setSmoothingTolerances(tolerances);
+			}
+		});
+	};
+	addToleranceAction("Energy decrease…", &ThreeD::ConvergenceMonitor::Tolerances::energy);
+	addToleranceAction("Gradient decrease…", &ThreeD::ConvergenceMonitor::Tolerances::gradient);
+	addToleranceAction("Point displacement…", &ThreeD::ConvergenceMonitor::Tolerances::displacement);
+	tolerancesMenu->addAction("Window…", [this] {
+		auto tolerances = this->knotWidget()->smoothingTolerances();
+		bool ok;
+		const int window = QInputDialog::getInt(this, "Set value", "Window (iterations)", (int)tolerances.window, 2, 10000, 10, &ok);
+		if (ok) {
+			tolerances.window = window;
+			this->knotWidget()->setSmoothingTolerances(tolerances);
+		}
+	});
+	knotMenu->addAction("Smoothing display interval…", [this] { this->knotWidget()->setSmoothingPublicationInterval(); });
 	knotMenu->addSeparator();
 	knotMenu->addAction("Visual options…", [this] { this->showOptionsDialog(); });
 	knotMenu->addAction("Number of points…", [this] { this->knotWidget()->setNumberOfPoints(); });
@@ -17,6 +17,7 @@
 #ifndef __KE_QT_KNOT_WINDOW_H__
 #define __KE_QT_KNOT_WINDOW_H__
 
+#include <QtCore/QTimer>
 #include <QtWidgets/QDialog>
 
 #include "Window.h"
@@ -61,8 +62,21 @@ signals:
 
 class KnotMathDialog : public QDialog {
 
+private:
+	struct Row;
+
+private:
+	std::vector<Row> rows;
+	QTimer *timer;
+
 public:
 	KnotMathDialog(KnotWindow &window);
+	~KnotMathDialog();
+
+private:
+	void update(Row &row);
+	void updatePending();
+	void cancelAll();
 };
 
 class KnotOptionsDialog : public QDialog {